@@ -0,0 +1,118 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Benchmark building and destructing expression trees made of variants with
+boxed children, with std::allocator and with rime::arena_allocator.
+With the arena, nodes are allocated by incrementing a pointer, and the tree
+is released at once without visiting the nodes.
+*/
+
+#include <memory>
+#include <vector>
+
+#include "rime/variant.hpp"
+#include "rime/boxed.hpp"
+#include "rime/arena.hpp"
+
+#include "bench_timer.hpp"
+
+namespace {
+
+    template <class Allocator> struct binary;
+
+    template <class Allocator> struct expression {
+        typedef rime::boxed <binary <Allocator>,
+            typename std::allocator_traits <Allocator>::template rebind_alloc
+                <binary <Allocator>>> box_type;
+        typedef rime::variant <int, box_type> type;
+    };
+
+    template <class Allocator> struct binary {
+        typedef typename expression <Allocator>::type expression_type;
+
+        expression_type left;
+        expression_type right;
+
+        binary (expression_type && left, expression_type && right)
+        : left (std::move (left)), right (std::move (right)) {}
+    };
+
+    /**
+    Build a balanced tree with \a depth levels of binary nodes, with leaves
+    taken from \a leaves.
+    */
+    template <class Allocator> typename expression <Allocator>::type build (
+        Allocator const & allocator, int depth,
+        std::vector <std::size_t>::const_iterator & leaves)
+    {
+        typedef typename expression <Allocator>::type expression_type;
+        typedef typename expression <Allocator>::box_type box_type;
+        if (depth == 0)
+            return expression_type (int (*leaves ++));
+        expression_type left = build (allocator, depth - 1, leaves);
+        expression_type right = build (allocator, depth - 1, leaves);
+        return expression_type (box_type (std::allocator_arg,
+            typename box_type::allocator_type (allocator),
+            std::move (left), std::move (right)));
+    }
+
+    struct sum {
+        int operator() (int i) const { return i; }
+
+        template <class Box> int operator() (Box const & box) const {
+            return rime::visit (*this) (box.get().left)
+                + rime::visit (*this) (box.get().right);
+        }
+    };
+
+    int const depth = 16;
+    std::size_t const node_num = (std::size_t (1) << depth) - 1;
+
+    RIME_BENCH_NOINLINE int build_heap (
+        std::vector <std::size_t> const & leaves)
+    {
+        std::vector <std::size_t>::const_iterator leaf = leaves.begin();
+        expression <std::allocator <int>>::type tree
+            = build (std::allocator <int>(), depth, leaf);
+        return rime::visit (sum()) (tree);
+    }
+
+    RIME_BENCH_NOINLINE int build_arena (
+        std::vector <std::size_t> const & leaves)
+    {
+        rime::arena arena;
+        std::vector <std::size_t>::const_iterator leaf = leaves.begin();
+        expression <rime::arena_allocator <int, true>>::type tree
+            = build (rime::arena_allocator <int, true> (arena), depth, leaf);
+        return rime::visit (sum()) (tree);
+    }
+
+} // namespace
+
+int main() {
+    std::vector <std::size_t> leaves =
+        rime_bench::random_indices (node_num + 1, 100);
+
+    rime_bench::run ("tree with std::allocator, per node", [&] {
+            rime_bench::do_not_optimise (build_heap (leaves));
+        }, node_num);
+    rime_bench::run ("tree with arena_allocator, per node", [&] {
+            rime_bench::do_not_optimise (build_arena (leaves));
+        }, node_num);
+    return 0;
+}
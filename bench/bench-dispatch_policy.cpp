@@ -0,0 +1,127 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Compare the dispatch policies in rime/dispatch_policy.hpp for rime::visit on
+variants with different numbers of alternatives, and report, for each number
+of alternatives, which policy is fastest.
+This is what the defaults for rime::dispatch_policy::automatic are based on.
+
+Each benchmark is run with the contained types distributed uniformly, which is
+hard on the branch predictor, and with the first type dominating.
+*/
+
+#include <vector>
+#include <string>
+
+#include "rime/variant.hpp"
+
+#include "bench_timer.hpp"
+
+namespace {
+
+    template <std::size_t ... Indices> struct indices {};
+
+    template <std::size_t Size, std::size_t ... Indices> struct make_indices
+    : make_indices <Size - 1, Size - 1, Indices ...> {};
+    template <std::size_t ... Indices> struct make_indices <0, Indices ...>
+    { typedef indices <Indices ...> type; };
+
+    template <std::size_t Index> struct alternative { long value; };
+
+    template <class Indices> struct variant_with;
+    template <std::size_t ... Indices> struct variant_with <indices <Indices ...>>
+    {
+        typedef rime::variant <alternative <Indices> ...> type;
+
+        static std::vector <type> prototypes()
+        { return { type (alternative <Indices> {long (Indices)}) ... }; }
+    };
+
+    struct weigh {
+        template <std::size_t Index>
+            long operator() (alternative <Index> const & a) const
+        { return a.value * long (Index + 1); }
+    };
+
+    template <class Policy, class Variant> RIME_BENCH_NOINLINE
+        long visit_all (std::vector <Variant> const & variants)
+    {
+        long total = 0;
+        for (Variant const & v : variants)
+            total += rime::visit <Policy> (weigh()) (v);
+        return total;
+    }
+
+    std::size_t const size = 1 << 20;
+
+    struct result {
+        std::string policy;
+        double time;
+    };
+
+    template <class Policy, class Variant> result time_policy (
+        std::string const & name, std::vector <Variant> const & variants)
+    {
+        double time = rime_bench::time_per_iteration ([&] {
+                rime_bench::do_not_optimise (
+                    visit_all <Policy> (variants));
+            }, variants.size());
+        rime_bench::report ("  " + name, time);
+        return result { name, time };
+    }
+
+    template <std::size_t ChoiceNum> void run_choice_num (bool skewed) {
+        typedef variant_with <typename make_indices <ChoiceNum>::type>
+            helper;
+        typedef typename helper::type variant;
+        std::vector <variant> prototypes = helper::prototypes();
+
+        std::vector <std::size_t> indices =
+            rime_bench::random_indices (size, skewed ? 100 : ChoiceNum);
+        std::vector <variant> variants;
+        variants.reserve (size);
+        for (std::size_t index : indices)
+            variants.push_back (prototypes [index < ChoiceNum ? index : 0]);
+
+        std::cout << ChoiceNum << " alternatives"
+            << (skewed ? ", skewed:" : ", uniform:") << std::endl;
+        result results [] = {
+            time_policy <rime::dispatch_policy::table> ("table", variants),
+            time_policy <rime::dispatch_policy::switch_statement> (
+                "switch_statement", variants),
+            time_policy <rime::dispatch_policy::if_chain> (
+                "if_chain", variants) };
+        result const * best = &results [0];
+        for (result const & r : results)
+            if (r.time < best->time)
+                best = &r;
+        std::cout << "  fastest: " << best->policy << std::endl;
+    }
+
+    template <std::size_t ... ChoiceNums> void run_all (bool skewed) {
+        int dummy [] = { (run_choice_num <ChoiceNums> (skewed), 0) ... };
+        (void) dummy;
+    }
+
+} // namespace
+
+int main() {
+    run_all <2, 3, 4, 5, 6, 8, 12, 16, 24, 32, 64> (false);
+    run_all <2, 3, 4, 5, 6, 8, 12, 16, 24, 32, 64> (true);
+    return 0;
+}
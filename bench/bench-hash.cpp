@@ -0,0 +1,96 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Compare calling std::hash on each element of a range of variants with
+rime::hash_range, in both orders.
+The contained types are random, either for each element, or for each run of 64
+elements, which is the case where the sequential order is meant to be faster.
+*/
+
+#include <string>
+#include <vector>
+
+#include "rime/hash.hpp"
+
+#include "bench_timer.hpp"
+
+namespace {
+
+    typedef rime::variant <int, float, double, long> variant;
+
+    std::size_t const size = 1 << 20;
+
+    /**
+    Make variants whose types are random for each run of \a run_length
+    elements.
+    */
+    std::vector <variant> make_variants (std::size_t run_length) {
+        std::vector <std::size_t> indices =
+            rime_bench::random_indices (size / run_length + 1, 4);
+        std::vector <variant> variants;
+        variants.reserve (size);
+        for (std::size_t i = 0; i != size; ++ i) {
+            switch (indices [i / run_length]) {
+            case 0: variants.push_back (variant (int (i))); break;
+            case 1: variants.push_back (variant (float (i))); break;
+            case 2: variants.push_back (variant (double (i))); break;
+            default: variants.push_back (variant (long (i)));
+            }
+        }
+        return variants;
+    }
+
+    RIME_BENCH_NOINLINE void hash_each (std::vector <variant> const & variants,
+        std::vector <std::size_t> & hashes)
+    {
+        std::hash <variant> hash;
+        for (std::size_t i = 0; i != variants.size(); ++ i)
+            hashes [i] = hash (variants [i]);
+    }
+
+    template <class Order> RIME_BENCH_NOINLINE void hash_range (
+        std::vector <variant> const & variants,
+        std::vector <std::size_t> & hashes)
+    {
+        rime::hash_range <Order> (
+            variants.begin(), variants.end(), hashes.begin());
+    }
+
+} // namespace
+
+int main() {
+    std::vector <std::size_t> hashes (size);
+    std::size_t const run_lengths [] = { 1, 64 };
+    for (std::size_t run_length : run_lengths) {
+        std::vector <variant> variants = make_variants (run_length);
+        std::string suffix = " (runs of " + std::to_string (run_length) + ")";
+        rime_bench::run ("std::hash per element" + suffix, [&] {
+                hash_each (variants, hashes);
+                rime_bench::do_not_optimise (hashes.back());
+            }, size);
+        rime_bench::run ("hash_range, grouped" + suffix, [&] {
+                hash_range <rime::visit_order::grouped> (variants, hashes);
+                rime_bench::do_not_optimise (hashes.back());
+            }, size);
+        rime_bench::run ("hash_range, sequential" + suffix, [&] {
+                hash_range <rime::visit_order::sequential> (variants, hashes);
+                rime_bench::do_not_optimise (hashes.back());
+            }, size);
+    }
+    return 0;
+}
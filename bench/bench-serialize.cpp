@@ -0,0 +1,145 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Benchmark the throughput of rime::serialize and rime::deserialize through a
+local pipe.
+Variants are serialised into a buffer, which is written to the pipe in
+batches that fit in the pipe's buffer, and read back and deserialised.
+This uses the POSIX functions pipe, read and write.
+*/
+
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "rime/serialize.hpp"
+
+#include "bench_timer.hpp"
+
+namespace {
+
+    struct point {
+        double x;
+        double y;
+    };
+
+    typedef rime::variant <char, int, double, point> variant;
+
+    /// Output that appends to a buffer.
+    struct buffer_output {
+        std::vector <char> buffer;
+
+        void write (char const * data, std::size_t size)
+        { buffer.insert (buffer.end(), data, data + size); }
+    };
+
+    /// Input that reads from a buffer.
+    struct buffer_input {
+        std::vector <char> buffer;
+        std::size_t position;
+
+        buffer_input() : position (0) {}
+
+        bool read (char * data, std::size_t size) {
+            if (buffer.size() - position < size)
+                return false;
+            std::memcpy (data, buffer.data() + position, size);
+            position += size;
+            return true;
+        }
+    };
+
+    void write_all (int descriptor, char const * data, std::size_t size) {
+        while (size != 0) {
+            ssize_t written = ::write (descriptor, data, size);
+            if (written <= 0)
+                throw std::runtime_error ("Cannot write to pipe");
+            data += written;
+            size -= std::size_t (written);
+        }
+    }
+
+    void read_all (int descriptor, char * data, std::size_t size) {
+        while (size != 0) {
+            ssize_t count = ::read (descriptor, data, size);
+            if (count <= 0)
+                throw std::runtime_error ("Cannot read from pipe");
+            data += count;
+            size -= std::size_t (count);
+        }
+    }
+
+    std::size_t const size = 1 << 18;
+    // The default pipe buffer on Linux is 64 KiB; a batch must fit in it.
+    std::size_t const batch_size = 1024;
+
+    RIME_BENCH_NOINLINE double round_trip (
+        std::vector <variant> const & variants, int const (&pipe) [2])
+    {
+        double total = 0;
+        buffer_output output;
+        buffer_input input;
+        for (std::size_t first = 0; first < variants.size();
+            first += batch_size)
+        {
+            output.buffer.clear();
+            for (std::size_t i = first;
+                i != first + batch_size && i != variants.size(); ++ i)
+                rime::serialize (output, variants [i]);
+            write_all (pipe [1], output.buffer.data(), output.buffer.size());
+
+            input.buffer.resize (output.buffer.size());
+            input.position = 0;
+            read_all (pipe [0], input.buffer.data(), input.buffer.size());
+            while (input.position != input.buffer.size()) {
+                variant v = rime::deserialize <variant> (input);
+                total += v.which();
+            }
+        }
+        return total;
+    }
+
+} // namespace
+
+int main() {
+    std::vector <std::size_t> indices = rime_bench::random_indices (size, 4);
+    std::vector <variant> variants;
+    variants.reserve (size);
+    for (std::size_t i = 0; i != size; ++ i) {
+        switch (indices [i]) {
+        case 0: variants.push_back (variant (char (i))); break;
+        case 1: variants.push_back (variant (int (i))); break;
+        case 2: variants.push_back (variant (double (i))); break;
+        default: variants.push_back (variant (point {double (i), 0.}));
+        }
+    }
+
+    int descriptors [2];
+    if (::pipe (descriptors) != 0)
+        return 1;
+
+    rime_bench::run ("serialise, pipe, deserialise, per variant", [&] {
+            rime_bench::do_not_optimise (round_trip (variants, descriptors));
+        }, size);
+
+    ::close (descriptors [0]);
+    ::close (descriptors [1]);
+    return 0;
+}
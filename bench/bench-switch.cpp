@@ -0,0 +1,129 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Benchmark dispatch through rime::detail::switch_.
+
+rime::detail::switch_ uses a function-pointer table that is a constant
+expression.
+This is compared with the previous implementation, reproduced below, which
+filled in the table at run time, in a function-local static variable.
+That needed a thread-safe initialisation guard to be checked on every call.
+
+To see the difference in the generated code, disassemble this benchmark and
+look for calls to __cxa_guard_acquire, or for loads of the guard variable,
+in dispatch_static_local and dispatch_constant:
+    objdump -d --no-show-raw-insn -C bench-switch | less
+Only the former should contain them.
+*/
+
+#include <cassert>
+#include <vector>
+
+#include "meta/vector.hpp"
+
+#include "rime/detail/switch.hpp"
+
+#include "bench_timer.hpp"
+
+namespace {
+
+    // The previous implementation of rime::detail::switch_.
+    template <class Result, class Arguments, class Choices>
+        struct static_local_switch_impl;
+
+    template <class Result, class ... Arguments, class ... Choices>
+        struct static_local_switch_impl <Result, meta::vector <Arguments ...>,
+            meta::vector <Choices ...>>
+    {
+        typedef Result (*function_pointer) (Arguments && ...);
+        function_pointer functions [sizeof ... (Choices)];
+
+        static_local_switch_impl() {
+            function_pointer pointers [] = {
+                &rime::detail::call_object <Choices, Result, Arguments ...> ...
+            };
+            for (std::size_t i = 0; i != sizeof ... (Choices); ++ i)
+                functions [i] = pointers [i];
+        }
+    };
+
+    template <class Result, class Choices> struct static_local_switch;
+
+    template <class Result, class ... Choices>
+        struct static_local_switch <Result, meta::vector <Choices ...>>
+    {
+        template <class ... Arguments>
+            Result operator() (std::size_t which, Arguments && ... arguments)
+            const
+        {
+            typedef static_local_switch_impl <Result,
+                meta::vector <Arguments ...>, meta::vector <Choices ...>>
+                implementation_type;
+            assert (which < sizeof ... (Choices));
+            static implementation_type implementation;
+            return implementation.functions [which] (
+                std::forward <Arguments> (arguments) ...);
+        }
+    };
+
+    template <int factor> struct times {
+        long operator() (long value) const { return factor * value; }
+    };
+
+    typedef meta::vector <times <1>, times <2>, times <3>, times <4>,
+        times <5>, times <6>, times <7>, times <8>> choices;
+
+    std::size_t const iterations = 1 << 22;
+
+    RIME_BENCH_NOINLINE long dispatch_static_local (
+        std::vector <std::size_t> const & indices)
+    {
+        static_local_switch <long, choices> s;
+        long total = 0;
+        for (std::size_t index : indices)
+            total += s (index, long (index));
+        return total;
+    }
+
+    RIME_BENCH_NOINLINE long dispatch_constant (
+        std::vector <std::size_t> const & indices)
+    {
+        rime::detail::switch_ <long, choices> s;
+        long total = 0;
+        for (std::size_t index : indices)
+            total += s (index, long (index));
+        return total;
+    }
+
+} // namespace
+
+int main() {
+    for (std::size_t bound : {1, 2, 8}) {
+        std::vector <std::size_t> indices =
+            rime_bench::random_indices (iterations, bound);
+        std::string suffix = " (" + std::to_string (bound) + " cases used)";
+
+        rime_bench::run ("switch_, static local table" + suffix, [&] {
+                rime_bench::do_not_optimise (dispatch_static_local (indices));
+            }, iterations);
+        rime_bench::run ("switch_, constant table" + suffix, [&] {
+                rime_bench::do_not_optimise (dispatch_constant (indices));
+            }, iterations);
+    }
+    return 0;
+}
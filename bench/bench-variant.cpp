@@ -0,0 +1,423 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Time the basic operations on rime::variant, and the same operations on
+boost::variant and, if compiled as C++17, std::variant, as baselines.
+
+The operations are construction, copy and move construction, destruction, get,
+visit with one, two, and three variants, operator(), operator==, and
+assignment; for rime::variant, also replace.
+Each is run for variants with different numbers of alternatives and with
+payloads of different sizes and kinds:
+\li "small": one long, trivially copyable;
+\li "large": eight longs, trivially copyable;
+\li "owning": a long and a std::string that allocates, so that copying and
+    destruction are not trivial.
+
+The contained types are random, so that dispatch is hard on the branch
+predictor.
+Each line reports the time per operation.
+
+The library is built as C++11, so to include std::variant, run, for example,
+    bjam bench-variant variant=release cxxflags=-std=c++17
+*/
+
+#include <cstddef>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+#include <boost/variant.hpp>
+#include <boost/variant/multivisitors.hpp>
+
+#if __cplusplus >= 201703L
+#  include <variant>
+#  define RIME_BENCH_STD_VARIANT 1
+#endif
+
+#include "rime/variant.hpp"
+
+#include "bench_timer.hpp"
+
+namespace {
+
+    std::size_t const size = 1 << 16;
+
+    /* Payloads. */
+
+    struct small_payload {
+        long value;
+        explicit small_payload (long value) : value (value) {}
+    };
+
+    struct large_payload {
+        long value;
+        long padding [7];
+        explicit large_payload (long value) : value (value), padding() {}
+    };
+
+    struct owning_payload {
+        long value;
+        // Longer than the small-string buffer, so that it allocates.
+        std::string text;
+        explicit owning_payload (long value)
+        : value (value), text (40, 'x') {}
+    };
+
+    template <std::size_t Index, class Payload> struct alternative {
+        Payload payload;
+
+        alternative() : payload (0) {}
+        explicit alternative (long value) : payload (value) {}
+
+        long operator() (long argument) const
+        { return payload.value * argument; }
+    };
+
+    template <std::size_t Index1, std::size_t Index2, class Payload>
+        inline bool operator == (alternative <Index1, Payload> const & a,
+            alternative <Index2, Payload> const & b)
+    { return a.payload.value == b.payload.value; }
+
+    struct weigh {
+        typedef long result_type;
+
+        template <std::size_t Index, class Payload>
+            long operator() (alternative <Index, Payload> const & a) const
+        { return a.payload.value * long (Index + 1); }
+
+        template <class First, class Second>
+            long operator() (First const & first, Second const & second) const
+        { return (*this) (first) + (*this) (second); }
+
+        template <class First, class Second, class Third>
+            long operator() (First const & first, Second const & second,
+                Third const & third) const
+        { return (*this) (first) + (*this) (second) + (*this) (third); }
+    };
+
+    struct call_with_three {
+        typedef long result_type;
+
+        template <class Alternative>
+            long operator() (Alternative const & a) const
+        { return a (3); }
+    };
+
+    /* Libraries. */
+
+    struct rime_library {
+        static std::string name() { return "rime"; }
+
+        template <class ... Types> struct variant
+        { typedef rime::variant <Types ...> type; };
+
+        template <class Type, class Variant>
+            static Type const & get (Variant const & v)
+        { return rime::get <Type> (v); }
+
+        template <class ... Variants>
+            static long visit (Variants const & ... variants)
+        { return rime::visit (weigh()) (variants ...); }
+
+        template <class Variant> static long call (Variant const & v)
+        { return v (3); }
+    };
+
+    struct boost_library {
+        static std::string name() { return "boost"; }
+
+        template <class ... Types> struct variant
+        { typedef boost::variant <Types ...> type; };
+
+        template <class Type, class Variant>
+            static Type const & get (Variant const & v)
+        { return boost::get <Type> (v); }
+
+        template <class ... Variants>
+            static long visit (Variants const & ... variants)
+        { return boost::apply_visitor (weigh(), variants ...); }
+
+        template <class Variant> static long call (Variant const & v)
+        { return boost::apply_visitor (call_with_three(), v); }
+    };
+
+#ifdef RIME_BENCH_STD_VARIANT
+    struct std_library {
+        static std::string name() { return "std"; }
+
+        template <class ... Types> struct variant
+        { typedef std::variant <Types ...> type; };
+
+        template <class Type, class Variant>
+            static Type const & get (Variant const & v)
+        { return std::get <Type> (v); }
+
+        template <class ... Variants>
+            static long visit (Variants const & ... variants)
+        { return std::visit (weigh(), variants ...); }
+
+        template <class Variant> static long call (Variant const & v)
+        { return std::visit (call_with_three(), v); }
+    };
+#endif
+
+    template <std::size_t ... Indices> struct indices {};
+
+    template <std::size_t Size, std::size_t ... Indices> struct make_indices
+    : make_indices <Size - 1, Size - 1, Indices ...> {};
+    template <std::size_t ... Indices> struct make_indices <0, Indices ...>
+    { typedef indices <Indices ...> type; };
+
+    /**
+    Time the destruction of copies of \a variants, which are made in raw
+    memory before the timer starts.
+    */
+    template <class Variant>
+        double time_destruction (std::vector <Variant> const & variants)
+    {
+        typedef typename std::aligned_storage <
+            sizeof (Variant), alignof (Variant)>::type storage;
+        std::vector <storage> memory (variants.size());
+        Variant * objects = reinterpret_cast <Variant *> (memory.data());
+
+        typedef std::chrono::steady_clock clock;
+        double best = -1;
+        for (int repetition = 0; repetition != 7; ++ repetition) {
+            for (std::size_t i = 0; i != variants.size(); ++ i)
+                new (objects + i) Variant (variants [i]);
+            clock::time_point start = clock::now();
+            for (std::size_t i = 0; i != variants.size(); ++ i)
+                objects [i].~Variant();
+            clock::time_point end = clock::now();
+            double nanoseconds = std::chrono::duration <double, std::nano> (
+                end - start).count();
+            if (best < 0 || nanoseconds < best)
+                best = nanoseconds;
+        }
+        return best / variants.size();
+    }
+
+    /**
+    Time move construction from copies of \a variants.
+    The copies are made again before each repetition, so that every
+    repetition moves from variants that have not been moved from yet.
+    */
+    template <class Variant>
+        double time_move_construction (std::vector <Variant> const & variants)
+    {
+        typedef std::chrono::steady_clock clock;
+        double best = -1;
+        for (int repetition = 0; repetition != 7; ++ repetition) {
+            std::vector <Variant> sources = variants;
+            clock::time_point start = clock::now();
+            for (std::size_t i = 0; i != sources.size(); ++ i) {
+                Variant v (std::move (sources [i]));
+                rime_bench::do_not_optimise (v);
+            }
+            clock::time_point end = clock::now();
+            double nanoseconds = std::chrono::duration <double, std::nano> (
+                end - start).count();
+            if (best < 0 || nanoseconds < best)
+                best = nanoseconds;
+        }
+        return best / variants.size();
+    }
+
+    template <class Variant> std::vector <Variant> shuffled (
+        std::vector <Variant> const & prototypes, std::size_t seed)
+    {
+        std::vector <std::size_t> choices =
+            rime_bench::random_indices (size + seed, prototypes.size());
+        std::vector <Variant> variants;
+        variants.reserve (size);
+        for (std::size_t i = 0; i != size; ++ i)
+            variants.push_back (prototypes [choices [i + seed]]);
+        return variants;
+    }
+
+    template <class Library, class Variant>
+        void run_visit_three (std::string const & prefix,
+            std::vector <Variant> const & variants,
+            std::vector <Variant> const & others, std::true_type)
+    {
+        rime_bench::run (prefix + "visit (3 variants)", [&] {
+                long total = 0;
+                for (std::size_t i = 0; i != size; ++ i)
+                    total += Library::visit (
+                        variants [i], others [i], variants [size - 1 - i]);
+                rime_bench::do_not_optimise (total);
+            }, size);
+    }
+
+    // Too many combinations to instantiate.
+    template <class Library, class Variant>
+        void run_visit_three (std::string const &,
+            std::vector <Variant> const &, std::vector <Variant> const &,
+            std::false_type)
+    {}
+
+    /**
+    Time rime::variant::replace, which requires void as one of the types.
+    */
+    template <class Payload, std::size_t ... Indices, class Variant>
+        void run_replace (std::string const & prefix, indices <Indices ...>,
+            std::vector <Variant> const & variants,
+            std::vector <Variant> const & others, std::true_type)
+    {
+        typedef rime::variant <void, alternative <Indices, Payload> ...>
+            void_variant;
+        std::vector <void_variant> targets (variants.begin(), variants.end());
+        std::vector <void_variant> sources (others.begin(), others.end());
+        rime_bench::run (prefix + "replace", [&] {
+                for (std::size_t i = 0; i != size; ++ i)
+                    targets [i].replace (sources [i]);
+                rime_bench::do_not_optimise (targets.back());
+            }, size);
+    }
+
+    // Other libraries do not have replace.
+    template <class Payload, class Indices, class Variant>
+        void run_replace (std::string const &, Indices,
+            std::vector <Variant> const &, std::vector <Variant> const &,
+            std::false_type)
+    {}
+
+    /**
+    Run all operations for one library, one payload, and one number of
+    alternatives.
+    */
+    template <class Library, class Payload, std::size_t ... Indices>
+        void run_all (std::string const & payload_name,
+            indices <Indices ...>)
+    {
+        static std::size_t const choice_num = sizeof ... (Indices);
+        typedef typename Library::template variant <
+            alternative <Indices, Payload> ...>::type variant;
+        typedef alternative <0, Payload> first_type;
+
+        std::string prefix = Library::name() + ", "
+            + std::to_string (choice_num) + " x " + payload_name + ": ";
+
+        std::vector <variant> prototypes = {
+            variant (alternative <Indices, Payload> (long (Indices))) ... };
+        std::vector <variant> variants = shuffled (prototypes, 0);
+        std::vector <variant> others = shuffled (prototypes, 1);
+
+        rime_bench::run (prefix + "construct", [&] {
+                for (std::size_t i = 0; i != size; ++ i) {
+                    variant v ((first_type (long (i))));
+                    rime_bench::do_not_optimise (v);
+                }
+            }, size);
+
+        rime_bench::run (prefix + "copy construct", [&] {
+                for (std::size_t i = 0; i != size; ++ i) {
+                    variant v (variants [i]);
+                    rime_bench::do_not_optimise (v);
+                }
+            }, size);
+
+        rime_bench::report (prefix + "move construct",
+            time_move_construction (variants));
+
+        rime_bench::report (prefix + "destruct", time_destruction (variants));
+
+        {
+            std::vector <variant> firsts (size, variant (first_type (1)));
+            rime_bench::run (prefix + "get", [&] {
+                    long total = 0;
+                    for (variant const & v : firsts)
+                        total += Library::template get <first_type> (v)
+                            .payload.value;
+                    rime_bench::do_not_optimise (total);
+                }, size);
+        }
+
+        rime_bench::run (prefix + "visit (1 variant)", [&] {
+                long total = 0;
+                for (variant const & v : variants)
+                    total += Library::visit (v);
+                rime_bench::do_not_optimise (total);
+            }, size);
+
+        rime_bench::run (prefix + "visit (2 variants)", [&] {
+                long total = 0;
+                for (std::size_t i = 0; i != size; ++ i)
+                    total += Library::visit (variants [i], others [i]);
+                rime_bench::do_not_optimise (total);
+            }, size);
+
+        run_visit_three <Library> (prefix, variants, others,
+            std::integral_constant <bool, (choice_num <= 8)>());
+
+        rime_bench::run (prefix + "operator()", [&] {
+                long total = 0;
+                for (variant const & v : variants)
+                    total += Library::call (v);
+                rime_bench::do_not_optimise (total);
+            }, size);
+
+        rime_bench::run (prefix + "operator==", [&] {
+                std::size_t equal = 0;
+                for (std::size_t i = 0; i != size; ++ i)
+                    if (variants [i] == others [i])
+                        ++ equal;
+                rime_bench::do_not_optimise (equal);
+            }, size);
+
+        {
+            std::vector <variant> targets = variants;
+            rime_bench::run (prefix + "assign", [&] {
+                    for (std::size_t i = 0; i != size; ++ i)
+                        targets [i] = others [i];
+                    rime_bench::do_not_optimise (targets.back());
+                }, size);
+        }
+
+        run_replace <Payload> (prefix, indices <Indices ...>(),
+            variants, others, std::is_same <Library, rime_library>());
+    }
+
+    template <class Library, class Payload>
+        void run_payload (std::string const & payload_name)
+    {
+        run_all <Library, Payload> (payload_name, make_indices <2>::type());
+        run_all <Library, Payload> (payload_name, make_indices <8>::type());
+        run_all <Library, Payload> (payload_name, make_indices <16>::type());
+    }
+
+    template <class Library> void run_library() {
+        run_payload <Library, small_payload> ("small");
+        run_payload <Library, large_payload> ("large");
+        run_payload <Library, owning_payload> ("owning");
+    }
+
+} // namespace
+
+int main() {
+    run_library <rime_library>();
+    run_library <boost_library>();
+#ifdef RIME_BENCH_STD_VARIANT
+    run_library <std_library>();
+#endif
+    return 0;
+}
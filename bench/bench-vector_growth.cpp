@@ -0,0 +1,86 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Benchmark growing a std::vector of variants by push_back.
+
+std::vector only moves its elements when it reallocates if their move
+constructor is noexcept; otherwise it copies them.
+rime::variant's move constructor is noexcept if the contained types' are.
+The previous behaviour is reproduced with a wrapper around the variant whose
+move constructor is not noexcept.
+*/
+
+#include <string>
+#include <vector>
+
+#include "rime/variant.hpp"
+
+#include "bench_timer.hpp"
+
+namespace {
+
+    typedef rime::variant <std::string, std::vector <char>> buffer;
+
+    static_assert (std::is_nothrow_move_constructible <buffer>::value,
+        "The move constructor of buffer should be noexcept.");
+
+    /**
+    Wrap a buffer, but with a move constructor that is not noexcept, as
+    rime::variant's used to be.
+    */
+    struct throwing_move_buffer {
+        buffer content;
+
+        throwing_move_buffer (buffer && content)
+        : content (std::move (content)) {}
+
+        throwing_move_buffer (throwing_move_buffer const & that)
+        : content (that.content) {}
+
+        throwing_move_buffer (throwing_move_buffer && that) noexcept (false)
+        : content (std::move (that.content)) {}
+    };
+
+    std::size_t const size = 1 << 16;
+
+    template <class Element> RIME_BENCH_NOINLINE std::size_t grow (
+        std::vector <std::size_t> const & indices)
+    {
+        std::vector <Element> elements;
+        for (std::size_t index : indices) {
+            if (index == 0)
+                elements.push_back (buffer (std::string (64, 'a')));
+            else
+                elements.push_back (buffer (std::vector <char> (256, 'b')));
+        }
+        return elements.size();
+    }
+
+} // namespace
+
+int main() {
+    std::vector <std::size_t> indices = rime_bench::random_indices (size, 2);
+
+    rime_bench::run ("push_back, move constructor not noexcept", [&] {
+            rime_bench::do_not_optimise (grow <throwing_move_buffer> (indices));
+        }, size);
+    rime_bench::run ("push_back, noexcept move constructor", [&] {
+            rime_bench::do_not_optimise (grow <buffer> (indices));
+        }, size);
+    return 0;
+}
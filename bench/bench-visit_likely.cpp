@@ -0,0 +1,84 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Compare rime::visit with rime::visit_likely <int> on variants that contain
+int 99% of the time.
+*/
+
+#include <vector>
+
+#include "rime/visit_likely.hpp"
+
+#include "bench_timer.hpp"
+
+namespace {
+
+    typedef rime::variant <int, float, double, long> variant;
+
+    std::size_t const size = 1 << 20;
+
+    std::vector <variant> make_variants() {
+        std::vector <std::size_t> indices =
+            rime_bench::random_indices (size, 100);
+        std::vector <variant> variants;
+        variants.reserve (size);
+        for (std::size_t i = 0; i != size; ++ i) {
+            switch (indices [i]) {
+            case 0: variants.push_back (variant (float (i))); break;
+            case 1: variants.push_back (variant (double (i))); break;
+            case 2: variants.push_back (variant (long (i))); break;
+            default: variants.push_back (variant (int (i)));
+            }
+        }
+        return variants;
+    }
+
+    struct to_long {
+        template <class Type> long operator() (Type value) const
+        { return long (value); }
+    };
+
+    RIME_BENCH_NOINLINE long sum_visit (std::vector <variant> const & variants)
+    {
+        long sum = 0;
+        for (variant const & v : variants)
+            sum += rime::visit (to_long()) (v);
+        return sum;
+    }
+
+    RIME_BENCH_NOINLINE long sum_visit_likely (
+        std::vector <variant> const & variants)
+    {
+        long sum = 0;
+        for (variant const & v : variants)
+            sum += rime::visit_likely <int> (to_long()) (v);
+        return sum;
+    }
+
+} // namespace
+
+int main() {
+    std::vector <variant> variants = make_variants();
+    rime_bench::run ("visit", [&] {
+            rime_bench::do_not_optimise (sum_visit (variants));
+        }, size);
+    rime_bench::run ("visit_likely <int>", [&] {
+            rime_bench::do_not_optimise (sum_visit_likely (variants));
+        }, size);
+    return 0;
+}
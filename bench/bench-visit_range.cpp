@@ -0,0 +1,102 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Compare calling rime::visit on each element of a range of variants with
+rime::visit_range, in both orders.
+The contained types are either random, which is hard on the branch predictor,
+or in runs of 64 elements of the same type.
+*/
+
+#include <vector>
+
+#include "rime/visit_range.hpp"
+
+#include "bench_timer.hpp"
+
+namespace {
+
+    typedef rime::variant <int, float, double, long> variant;
+
+    struct accumulate {
+        double & total;
+        explicit accumulate (double & total) : total (total) {}
+
+        template <class Type> void operator() (Type value) const
+        { total += value; }
+    };
+
+    std::size_t const size = 1 << 20;
+
+    std::vector <variant> make_variants (bool runs) {
+        std::vector <std::size_t> indices =
+            rime_bench::random_indices (size, 4);
+        std::vector <variant> variants;
+        variants.reserve (size);
+        for (std::size_t i = 0; i != size; ++ i) {
+            std::size_t index = runs ? indices [i / 64] : indices [i];
+            switch (index) {
+            case 0: variants.push_back (variant (int (i))); break;
+            case 1: variants.push_back (variant (float (i))); break;
+            case 2: variants.push_back (variant (double (i))); break;
+            default: variants.push_back (variant (long (i)));
+            }
+        }
+        return variants;
+    }
+
+    RIME_BENCH_NOINLINE double visit_each (
+        std::vector <variant> const & variants)
+    {
+        double total = 0;
+        for (variant const & v : variants)
+            rime::visit (accumulate (total)) (v);
+        return total;
+    }
+
+    template <class Order> RIME_BENCH_NOINLINE double visit_range (
+        std::vector <variant> const & variants)
+    {
+        double total = 0;
+        rime::visit_range <Order> (
+            accumulate (total), variants.begin(), variants.end());
+        return total;
+    }
+
+    void run (bool runs) {
+        std::vector <variant> variants = make_variants (runs);
+        std::string suffix = runs ? " (runs)" : " (random)";
+        rime_bench::run ("visit per element" + suffix, [&] {
+                rime_bench::do_not_optimise (visit_each (variants));
+            }, size);
+        rime_bench::run ("visit_range, grouped" + suffix, [&] {
+                rime_bench::do_not_optimise (
+                    visit_range <rime::visit_order::grouped> (variants));
+            }, size);
+        rime_bench::run ("visit_range, sequential" + suffix, [&] {
+                rime_bench::do_not_optimise (
+                    visit_range <rime::visit_order::sequential> (variants));
+            }, size);
+    }
+
+} // namespace
+
+int main() {
+    run (false);
+    run (true);
+    return 0;
+}
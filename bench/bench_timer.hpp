@@ -0,0 +1,131 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Minimal timing harness for the benchmarks in this directory.
+Each benchmark is a function that is run a number of times; the best time
+per iteration is reported, which is the least noisy statistic on a machine
+that is doing other things too.
+*/
+
+#ifndef RIME_BENCH_TIMER_HPP_INCLUDED
+#define RIME_BENCH_TIMER_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+
+/**
+Mark a function as not to be inlined, so that it can be found in the
+disassembly and so that the compiler cannot specialise it for its call site.
+*/
+#if defined (__GNUC__) || defined (__clang__)
+#  define RIME_BENCH_NOINLINE __attribute__ ((noinline))
+#else
+#  define RIME_BENCH_NOINLINE
+#endif
+
+namespace rime_bench {
+
+/**
+Prevent the compiler from optimising away the computation of \a value.
+*/
+template <class Type> inline void do_not_optimise (Type const & value) {
+#if defined (__GNUC__) || defined (__clang__)
+    asm volatile ("" : : "r,m" (value) : "memory");
+#else
+    static volatile char const * sink;
+    sink = reinterpret_cast <char const *> (&value);
+#endif
+}
+
+/**
+Prevent the compiler from assuming anything about the contents of \a value.
+This is useful to stop it from constant-folding the benchmark's input.
+*/
+template <class Type> inline void clobber (Type & value) {
+#if defined (__GNUC__) || defined (__clang__)
+    asm volatile ("" : "+r,m" (value) : : "memory");
+#else
+    do_not_optimise (value);
+#endif
+}
+
+/**
+Run \a function \a repetitions times, and return the best time in nanoseconds
+divided by \a iterations, the number of operations that one call to
+\a function performs.
+*/
+template <class Function> inline double time_per_iteration (
+    Function function, std::size_t iterations, int repetitions = 7)
+{
+    typedef std::chrono::steady_clock clock;
+    double best = -1;
+    for (int repetition = 0; repetition != repetitions; ++ repetition) {
+        clock::time_point start = clock::now();
+        function();
+        clock::time_point end = clock::now();
+        double nanoseconds = std::chrono::duration <double, std::nano> (
+            end - start).count();
+        if (best < 0 || nanoseconds < best)
+            best = nanoseconds;
+    }
+    return best / iterations;
+}
+
+/**
+Print one line of results in a fixed format:
+    name    nanoseconds-per-iteration
+*/
+inline void report (std::string const & name, double nanoseconds) {
+    std::cout << std::left << std::setw (48) << name << ' '
+        << std::right << std::fixed << std::setprecision (3) << std::setw (10)
+        << nanoseconds << " ns" << std::endl;
+}
+
+template <class Function> inline void run (std::string const & name,
+    Function function, std::size_t iterations)
+{ report (name, time_per_iteration (function, iterations)); }
+
+/**
+Return \a count pseudo-random numbers in [0, bound).
+The sequence is deterministic, so that runs are comparable.
+*/
+inline std::vector <std::size_t> random_indices (
+    std::size_t count, std::size_t bound)
+{
+    std::vector <std::size_t> result;
+    result.reserve (count);
+    std::uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (std::size_t i = 0; i != count; ++ i) {
+        // xorshift64*.
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        result.push_back (
+            std::size_t ((state * 0x2545F4914F6CDD1Dull) >> 33) % bound);
+    }
+    return result;
+}
+
+} // namespace rime_bench
+
+#endif // RIME_BENCH_TIMER_HPP_INCLUDED
@@ -0,0 +1,198 @@
+#!/usr/bin/env python
+
+# Copyright 2015 Rogier van Dalen.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Measure how long it takes to compile code that uses rime::variant.
+
+This generates translation units that
+- only include rime/variant.hpp ("include");
+- define a variant with a number of alternatives, and copy, assign, and
+  destruct it ("variant");
+- call rime::visit on one or more of those variants ("visit").
+Each is compiled separately, and the wall-clock time and the peak memory use of
+the compiler are written as CSV to the standard output (or to --output).
+
+The numbers of alternatives are 2, 4, ..., 64, and the numbers of variants
+that are visited at once 1 to 4.
+visit instantiates one function for each combination of types, so
+combinations with more than --max-combinations are skipped.
+
+Rime depends on Boost and on the "meta" and "utility" libraries.
+Pass their include directories with -I, for example:
+
+    bench/compile_time.py -I ../meta/include -I ../utility/include \\
+        --output compile_time.csv
+
+Run this from the root directory of the "rime" repository.
+The peak memory use includes that of a copy of this Python process, which
+exists briefly before the compiler is started, so it is never less than a few
+megabytes.
+Extra flags for the compiler can be given with --cxxflags; for example,
+--cxxflags=-ftime-report makes GCC print where the time goes to the standard
+error.
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import resource
+import shlex
+import subprocess
+import sys
+import tempfile
+import time
+
+alternative_counts = [2, 4, 8, 16, 32, 64]
+variant_counts = [1, 2, 3, 4]
+
+prologue = """
+#include "rime/variant.hpp"
+
+template <int Index> struct alternative { long value; };
+
+struct weigh {
+    template <int Index> long operator() (alternative <Index> const & a) const
+    { return a.value * (Index + 1); }
+
+    template <class First, class Second, class ... Rest>
+        long operator() (First const & first, Second const & second,
+            Rest const & ... rest) const
+    { return (*this) (first) + (*this) (second, rest ...); }
+};
+"""
+
+
+def variant_type(alternative_count):
+    return 'rime::variant <%s>' % ', '.join(
+        'alternative <%d>' % index for index in range(alternative_count))
+
+
+def include_source():
+    return '#include "rime/variant.hpp"\n'
+
+
+def variant_source(alternative_count):
+    return prologue + """
+typedef %s variant;
+
+void use (variant & target, variant const & source) {
+    variant copy (source);
+    variant moved (std::move (copy));
+    target = moved;
+}
+""" % variant_type(alternative_count)
+
+
+def visit_source(alternative_count, variant_count):
+    parameters = ', '.join(
+        'variant const & v%d' % index for index in range(variant_count))
+    arguments = ', '.join('v%d' % index for index in range(variant_count))
+    return prologue + """
+typedef %s variant;
+
+long use (%s) { return rime::visit (weigh()) (%s); }
+""" % (variant_type(alternative_count), parameters, arguments)
+
+
+def compile_source(source, compiler, flags):
+    """
+    Compile source and return the wall-clock time in seconds and the peak
+    memory use in kilobytes.
+    """
+    handle, file_name = tempfile.mkstemp(suffix='.cpp')
+    try:
+        with os.fdopen(handle, 'w') as source_file:
+            source_file.write(source)
+        command = ([compiler] + flags
+                   + ['-c', file_name, '-o', os.devnull])
+        # Each compilation is done in a child of this process, so that
+        # RUSAGE_CHILDREN gives the peak memory use of the compiler itself.
+        read_pipe, write_pipe = os.pipe()
+        child = os.fork()
+        if child == 0:
+            os.close(read_pipe)
+            start = time.time()
+            status = subprocess.call(command)
+            seconds = time.time() - start
+            peak = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss
+            os.write(write_pipe, ('%d %f %d' % (
+                status, seconds, peak)).encode())
+            os._exit(0)
+        os.close(write_pipe)
+        result = b''
+        while True:
+            data = os.read(read_pipe, 1024)
+            if not data:
+                break
+            result += data
+        os.close(read_pipe)
+        os.waitpid(child, 0)
+        status, seconds, peak = result.decode().split()
+        if int(status) != 0:
+            raise RuntimeError('Compilation failed: ' + ' '.join(command))
+        return float(seconds), int(peak)
+    finally:
+        os.remove(file_name)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('-I', dest='include_directories', action='append',
+                        default=[], help='add an include directory')
+    parser.add_argument('--compiler', default=os.environ.get('CXX', 'g++'),
+                        help='the compiler (default: $CXX, or g++)')
+    parser.add_argument('--cxxflags', default='-std=c++11 -O2',
+                        help='flags for the compiler (default: %(default)s)')
+    parser.add_argument('--max-combinations', type=int, default=4096,
+                        help='skip visits with more combinations of types '
+                        '(default: %(default)s)')
+    parser.add_argument('--output', help='the CSV file to write')
+    arguments = parser.parse_args()
+
+    flags = (shlex.split(arguments.cxxflags) + ['-Iinclude']
+             + ['-I' + directory
+                for directory in arguments.include_directories])
+
+    output = open(arguments.output, 'w') if arguments.output else sys.stdout
+
+    def record(kind, alternative_count, variant_count, source):
+        seconds, peak = compile_source(source, arguments.compiler, flags)
+        print('%s,%d,%d,%.3f,%d' % (
+            kind, alternative_count, variant_count, seconds, peak),
+            file=output)
+        output.flush()
+
+    print('kind,alternatives,variants,seconds,peak_memory_kb', file=output)
+    record('include', 0, 0, include_source())
+    for alternative_count in alternative_counts:
+        record('variant', alternative_count, 1,
+               variant_source(alternative_count))
+        for variant_count in variant_counts:
+            if (alternative_count ** variant_count
+                    > arguments.max_combinations):
+                continue
+            record('visit', alternative_count, variant_count,
+                   visit_source(alternative_count, variant_count))
+
+    if output is not sys.stdout:
+        output.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,231 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Define a monotonic arena and an allocator that allocates from it.
+This can be used with rime::boxed to build recursive variants, for example
+expression trees, whose nodes are all released at once.
+*/
+
+#ifndef RIME_ARENA_HPP_INCLUDED
+#define RIME_ARENA_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/mpl/bool.hpp>
+
+#include "rime/boxed.hpp"
+
+namespace rime {
+
+/**
+Monotonic memory resource.
+Memory is allocated from large blocks by incrementing a pointer.
+Deallocating does nothing; all memory is released at once when the arena is
+destructed, or when release() is called.
+Destructors of the objects in the arena are not called when the memory is
+released.
+
+An arena is not copyable, and not thread-safe.
+*/
+class arena {
+    std::size_t block_size_;
+    std::vector <std::unique_ptr <char []>> blocks_;
+    char * current_;
+    std::size_t left_;
+
+    friend class arena_scope;
+
+    static arena * & current_arena() {
+        static thread_local arena * current = nullptr;
+        return current;
+    }
+
+public:
+    /**
+    \param block_size
+        The size of each block that memory is allocated from.
+        Allocations larger than this get a block of their own.
+    */
+    explicit arena (std::size_t block_size = 64 * 1024)
+    : block_size_ (block_size), current_ (nullptr), left_ (0) {}
+
+    arena (arena const &) = delete;
+    arena & operator= (arena const &) = delete;
+
+    /**
+    \return Memory for \a size bytes, aligned to \a alignment, which must be
+    a power of two.
+    */
+    void * allocate (std::size_t size, std::size_t alignment) {
+        assert ((alignment & (alignment - 1)) == 0);
+        std::size_t padding = std::size_t (
+            -reinterpret_cast <std::uintptr_t> (current_) & (alignment - 1));
+        if (padding + size > left_) {
+            new_block (size + alignment - 1);
+            padding = std::size_t (
+                -reinterpret_cast <std::uintptr_t> (current_)
+                & (alignment - 1));
+        }
+        char * result = current_ + padding;
+        current_ = result + size;
+        left_ -= padding + size;
+        return result;
+    }
+
+    /**
+    Release all memory at once.
+    Any objects allocated in the arena must not be used after this.
+    */
+    void release() {
+        blocks_.clear();
+        current_ = nullptr;
+        left_ = 0;
+    }
+
+    /**
+    \return The number of blocks currently allocated.
+    */
+    std::size_t block_num() const { return blocks_.size(); }
+
+    /**
+    \return The arena that the innermost arena_scope on this thread has made
+    current, or nullptr if there is none.
+    */
+    static arena * current() { return current_arena(); }
+
+private:
+    void new_block (std::size_t minimum_size) {
+        std::size_t size = minimum_size > block_size_
+            ? minimum_size : block_size_;
+        blocks_.emplace_back (new char [size]);
+        current_ = blocks_.back().get();
+        left_ = size;
+    }
+};
+
+/**
+Make an arena the current arena of this thread while this object exists.
+A default-constructed arena_allocator allocates from the current arena.
+Scopes can be nested; when one is destructed, the previous arena becomes
+current again.
+*/
+class arena_scope {
+    arena * previous_;
+
+public:
+    explicit arena_scope (arena & a) : previous_ (arena::current_arena())
+    { arena::current_arena() = &a; }
+
+    ~arena_scope() { arena::current_arena() = previous_; }
+
+    arena_scope (arena_scope const &) = delete;
+    arena_scope & operator= (arena_scope const &) = delete;
+};
+
+/**
+Exception that is thrown when an arena_allocator is default-constructed while
+no arena_scope is active on the thread.
+*/
+class no_current_arena : public std::logic_error {
+public:
+    no_current_arena()
+    : std::logic_error ("rime::arena_allocator: no current arena; "
+        "use rime::arena_scope") {}
+};
+
+/**
+Standard-library allocator that allocates from a rime::arena.
+Deallocation does nothing: the arena releases the memory.
+
+By default, rime::boxed with this allocator still destructs its object, so
+that objects that hold other resources, like std::string, release them.
+If \a SkipDestructors is true, allocator_releases_all is true for this
+allocator, so rime::boxed with it does not destruct its object, and is
+trivially destructible.
+Only opt in to this if the objects do not hold resources other than memory
+in the same arena.
+
+It can be constructed from the arena.
+A default-constructed arena_allocator allocates from the current arena of the
+thread, which must be set with arena_scope.
+This is what happens when a variant with
+storage_policy::box_larger_than <MaxSize, arena_allocator <void>> boxes an
+alternative that it is constructed from.
+Copying or moving such a variant uses the allocator of the box that is copied
+or moved from.
+*/
+template <class Type, bool SkipDestructors = false> class arena_allocator {
+    template <class Other, bool OtherSkipDestructors>
+        friend class arena_allocator;
+
+    arena * arena_;
+
+public:
+    typedef Type value_type;
+
+    template <class Other> struct rebind
+    { typedef arena_allocator <Other, SkipDestructors> other; };
+
+    /**
+    Allocate from the current arena of this thread.
+    \throw no_current_arena If there is no current arena.
+    */
+    arena_allocator() : arena_ (arena::current()) {
+        if (!arena_)
+            throw no_current_arena();
+    }
+
+    explicit arena_allocator (arena & a) : arena_ (&a) {}
+
+    template <class Other>
+        arena_allocator (arena_allocator <Other, SkipDestructors> const & that)
+    : arena_ (that.arena_) {}
+
+    Type * allocate (std::size_t size) {
+        return static_cast <Type *> (
+            arena_->allocate (size * sizeof (Type), alignof (Type)));
+    }
+
+    void deallocate (Type *, std::size_t) {}
+
+    rime::arena & get_arena() const { return *arena_; }
+
+    template <class Other>
+        bool operator== (arena_allocator <Other, SkipDestructors> const & that)
+        const
+    { return arena_ == that.arena_; }
+
+    template <class Other>
+        bool operator!= (arena_allocator <Other, SkipDestructors> const & that)
+        const
+    { return arena_ != that.arena_; }
+};
+
+template <class Type>
+    struct allocator_releases_all <arena_allocator <Type, true>>
+: boost::mpl::true_ {};
+
+} // namespace rime
+
+#endif // RIME_ARENA_HPP_INCLUDED
@@ -0,0 +1,228 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Define a box that holds one object on the heap.
+*/
+
+#ifndef RIME_BOXED_HPP_INCLUDED
+#define RIME_BOXED_HPP_INCLUDED
+
+#include <cassert>
+#include <memory>
+#include <utility>
+
+#include <boost/mpl/bool.hpp>
+
+namespace rime {
+
+/**
+Compile-time constant that is true iff memory from \a Allocator is released
+all at once, by its owner, and not per object.
+Objects allocated with such an allocator then need not be destructed or
+deallocated one by one, so that rime::boxed with such an allocator is
+trivially destructible.
+This is false by default; specialise it for allocators that allocate from an
+arena, such as rime::arena_allocator <Type, true>.
+*/
+template <class Allocator> struct allocator_releases_all
+: boost::mpl::false_ {};
+
+namespace boxed_detail {
+
+    /**
+    Hold the allocator and the pointer to the object.
+    */
+    template <class Type, class Allocator> class boxed_data
+    : private Allocator
+    {
+    protected:
+        typedef std::allocator_traits <Allocator> traits;
+        typedef typename traits::pointer pointer;
+
+        pointer object_;
+
+        Allocator & allocator() { return *this; }
+        Allocator const & allocator() const { return *this; }
+
+        template <class ... Arguments>
+            boxed_data (Allocator const & allocator, Arguments && ... arguments)
+        : Allocator (allocator),
+            object_ (create (std::forward <Arguments> (arguments) ...)) {}
+
+        boxed_data (boxed_data && that) noexcept
+        : Allocator (std::move (that.allocator())), object_ (that.object_)
+        { that.object_ = pointer(); }
+
+        template <class ... Arguments>
+            pointer create (Arguments && ... arguments)
+        {
+            pointer object = traits::allocate (allocator(), 1);
+            try {
+                traits::construct (allocator(), std::addressof (*object),
+                    std::forward <Arguments> (arguments) ...);
+            } catch (...) {
+                traits::deallocate (allocator(), object, 1);
+                throw;
+            }
+            return object;
+        }
+
+        void destroy() {
+            if (object_) {
+                traits::destroy (allocator(), std::addressof (*object_));
+                traits::deallocate (allocator(), object_, 1);
+            }
+        }
+    };
+
+    /**
+    Destruct and deallocate the object, unless the allocator releases all
+    memory at once.
+    In that case, the destructor is trivial.
+    */
+    template <bool ReleasesAll, class Type, class Allocator>
+        class boxed_destructor_base;
+
+    template <class Type, class Allocator>
+        class boxed_destructor_base <true, Type, Allocator>
+    : public boxed_data <Type, Allocator>
+    {
+    protected:
+        template <class ... Arguments>
+            boxed_destructor_base (Arguments && ... arguments)
+        : boxed_data <Type, Allocator> (
+            std::forward <Arguments> (arguments) ...) {}
+    };
+
+    template <class Type, class Allocator>
+        class boxed_destructor_base <false, Type, Allocator>
+    : public boxed_data <Type, Allocator>
+    {
+    protected:
+        template <class ... Arguments>
+            boxed_destructor_base (Arguments && ... arguments)
+        : boxed_data <Type, Allocator> (
+            std::forward <Arguments> (arguments) ...) {}
+
+        boxed_destructor_base (boxed_destructor_base &&) = default;
+
+        ~boxed_destructor_base() { this->destroy(); }
+    };
+
+} // namespace boxed_detail
+
+/**
+Hold one object of type \a Type, allocated on the heap with \a Allocator.
+This has value semantics: copying a boxed copies the object into a new box.
+Moving a boxed, however, moves only the pointer, and leaves the source
+without an object; then it can only be assigned to or destructed.
+Assigning a boxed assigns the object, or, if the box has no object, copies
+the object into a new box.
+
+Boxing a large type reduces the size of the object that contains the box to
+the size of a pointer (plus the allocator, if it is not empty).
+rime::variant uses this to store large alternatives out of line: see
+rime::storage_policy::box_larger_than.
+
+\a Type can be incomplete where boxed <Type> is used, so that boxed can be
+used as an alternative of a variant that \a Type itself contains, to build
+recursive structures.
+With an allocator for which allocator_releases_all is true, such as
+rime::arena_allocator <Type, true>, the whole structure can be released at once: then
+boxed is trivially destructible, and so are variants that contain it, so
+that destructing the structure does nothing.
+
+\tparam Allocator
+    The allocator to use.
+    The allocator is stored in the box, but since boxed derives from it, an
+    empty allocator takes no space.
+*/
+template <class Type, class Allocator = std::allocator <Type>>
+    class boxed
+: public boxed_detail::boxed_destructor_base <
+    allocator_releases_all <Allocator>::value, Type, Allocator>
+{
+    typedef boxed_detail::boxed_destructor_base <
+        allocator_releases_all <Allocator>::value, Type, Allocator> base_type;
+    typedef typename base_type::traits traits;
+
+public:
+    typedef Type value_type;
+    typedef Allocator allocator_type;
+
+    /**
+    Construct the object from \a arguments, with memory from \a allocator.
+    */
+    template <class ... Arguments>
+        boxed (std::allocator_arg_t, Allocator const & allocator,
+            Arguments && ... arguments)
+    : base_type (allocator, std::forward <Arguments> (arguments) ...) {}
+
+    boxed (Type const & object)
+    : base_type (Allocator(), object) {}
+
+    boxed (Type && object)
+    : base_type (Allocator(), std::move (object)) {}
+
+    boxed (boxed const & that)
+    : base_type (traits::select_on_container_copy_construction (
+            that.get_allocator()), that.get()) {}
+
+    /**
+    Take over the object from \a that, which is left without an object.
+    */
+    boxed (boxed && that) noexcept = default;
+
+    /**
+    Copy the object of \a that.
+    If this has an object, this uses the copy assignment of Type; otherwise,
+    it allocates a new object with the allocator of this box.
+    The allocator is not changed.
+    */
+    boxed & operator= (boxed const & that) {
+        if (this->object_)
+            *this->object_ = that.get();
+        else
+            this->object_ = this->create (that.get());
+        return *this;
+    }
+
+    Allocator get_allocator() const { return this->allocator(); }
+
+    Type & get() {
+        assert (this->object_);
+        return *this->object_;
+    }
+
+    Type const & get() const {
+        assert (this->object_);
+        return *this->object_;
+    }
+};
+
+/**
+Compile-time constant that is true iff \a Type is a specialisation of boxed.
+*/
+template <class Type> struct is_boxed : boost::mpl::false_ {};
+
+template <class Type, class Allocator>
+    struct is_boxed <boxed <Type, Allocator>> : boost::mpl::true_ {};
+
+} // namespace rime
+
+#endif // RIME_BOXED_HPP_INCLUDED
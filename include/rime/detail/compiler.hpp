@@ -0,0 +1,49 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Compiler hints for separating fast paths from slow paths.
+*/
+
+#ifndef RIME_DETAIL_COMPILER_HPP_INCLUDED
+#define RIME_DETAIL_COMPILER_HPP_INCLUDED
+
+/**
+Mark a function as not to be inlined.
+This keeps code that is rarely executed out of the caller, so that the fast
+path stays small.
+*/
+#if defined (__GNUC__) || defined (__clang__)
+#  define RIME_DETAIL_NOINLINE __attribute__ ((noinline))
+#elif defined (_MSC_VER)
+#  define RIME_DETAIL_NOINLINE __declspec (noinline)
+#else
+#  define RIME_DETAIL_NOINLINE
+#endif
+
+/**
+Indicate that the condition is expected to be true or false.
+*/
+#if defined (__GNUC__) || defined (__clang__)
+#  define RIME_DETAIL_LIKELY(condition) __builtin_expect (!!(condition), 1)
+#  define RIME_DETAIL_UNLIKELY(condition) __builtin_expect (!!(condition), 0)
+#else
+#  define RIME_DETAIL_LIKELY(condition) (condition)
+#  define RIME_DETAIL_UNLIKELY(condition) (condition)
+#endif
+
+#endif // RIME_DETAIL_COMPILER_HPP_INCLUDED
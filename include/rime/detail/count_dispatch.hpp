@@ -0,0 +1,42 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Define the hook that the dispatch sites use to count dispatches.
+Only if RIME_DISPATCH_PROFILE is defined does this include
+rime/dispatch_profile.hpp; otherwise the hook does nothing, and the headers
+that dispatch do not depend on the profiling code.
+*/
+
+#ifndef RIME_DETAIL_COUNT_DISPATCH_HPP_INCLUDED
+#define RIME_DETAIL_COUNT_DISPATCH_HPP_INCLUDED
+
+/**
+\def RIME_DETAIL_COUNT_DISPATCH(Site, ChoiceNum, index)
+Count one dispatch to alternative \a index out of \a ChoiceNum at the site
+identified by the type \a Site.
+This expands to nothing unless RIME_DISPATCH_PROFILE is defined.
+*/
+#ifdef RIME_DISPATCH_PROFILE
+#  include "rime/dispatch_profile.hpp"
+#  define RIME_DETAIL_COUNT_DISPATCH(Site, ChoiceNum, index) \
+    ::rime::dispatch_profile::detail::count <Site, ChoiceNum> (index)
+#else
+#  define RIME_DETAIL_COUNT_DISPATCH(Site, ChoiceNum, index) ((void) 0)
+#endif
+
+#endif // RIME_DETAIL_COUNT_DISPATCH_HPP_INCLUDED
@@ -0,0 +1,134 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Define the layout of variant records that are stored back to back as a tag
+followed by the object: in memory, by packed_variant_sequence, and on disk,
+by the functions in rime/variant_records.hpp.
+*/
+
+#ifndef RIME_DETAIL_PACKED_LAYOUT_HPP_INCLUDED
+#define RIME_DETAIL_PACKED_LAYOUT_HPP_INCLUDED
+
+#include <cstddef>
+#include <type_traits>
+
+#include <boost/integer.hpp>
+
+namespace rime { namespace variant_detail {
+
+    /**
+    The size and alignment of the payload of a record of type Type.
+    void records have no payload.
+    */
+    template <class Type> struct packed_payload {
+        static const std::size_t size = sizeof (Type);
+        static const std::size_t alignment = alignof (Type);
+        static const bool trivially_destructible
+            = std::is_trivially_destructible <Type>::value;
+        static const bool trivially_copyable
+            = std::is_trivially_copyable <Type>::value;
+    };
+
+    template <> struct packed_payload <void> {
+        static const std::size_t size = 0;
+        static const std::size_t alignment = 1;
+        static const bool trivially_destructible = true;
+        static const bool trivially_copyable = true;
+    };
+
+    template <std::size_t ... Values> struct max_of;
+
+    template <std::size_t Value> struct max_of <Value> {
+        static const std::size_t value = Value;
+    };
+
+    template <std::size_t First, std::size_t ... Rest>
+        struct max_of <First, Rest ...>
+    {
+        static const std::size_t value = First > max_of <Rest ...>::value
+            ? First : max_of <Rest ...>::value;
+    };
+
+    /**
+    The type with which a const view refers to a record of type Type.
+    */
+    template <class Type> struct packed_const_element
+    { typedef Type const type; };
+
+    template <> struct packed_const_element <void> { typedef void type; };
+
+    inline std::size_t round_up (std::size_t offset, std::size_t alignment)
+    { return (offset + alignment - 1) & ~(alignment - 1); }
+
+    /**
+    Layout of records of one of Types.
+    A record consists of the index of its type, in the smallest unsigned
+    integer that fits, followed by the object at its own alignment.
+    The next record starts at the first offset after it that is aligned for
+    the index.
+    Offsets are relative to a base address that is aligned to "alignment".
+    */
+    template <class ... Types> struct packed_layout {
+        typedef typename boost::uint_value_t <sizeof ... (Types)>::least
+            which_type;
+
+        /// The alignment that the base address must have.
+        static const std::size_t alignment = max_of <alignof (which_type),
+            packed_payload <Types>::alignment ...>::value;
+
+        static constexpr std::size_t payload_sizes [sizeof ... (Types)]
+            = { packed_payload <Types>::size ... };
+        static constexpr std::size_t payload_alignments [sizeof ... (Types)]
+            = { packed_payload <Types>::alignment ... };
+
+        /**
+        \return The offset of the payload of a record of type \a which whose
+        tag is at offset \a tag.
+        */
+        static std::size_t payload_offset (std::size_t which, std::size_t tag)
+        {
+            return round_up (
+                tag + sizeof (which_type), payload_alignments [which]);
+        }
+
+        /**
+        \return The offset just past the end of a record of type \a which
+        whose tag is at offset \a tag.
+        This is where the tag of the next record goes.
+        */
+        static std::size_t record_end (std::size_t which, std::size_t tag) {
+            return round_up (payload_offset (which, tag) + payload_sizes [which],
+                alignof (which_type));
+        }
+
+        /**
+        \return The index of the type of the record whose tag is at
+        \a address.
+        */
+        static std::size_t which (char const * address)
+        { return *reinterpret_cast <which_type const *> (address); }
+    };
+
+    template <class ... Types> constexpr std::size_t
+        packed_layout <Types ...>::payload_sizes [sizeof ... (Types)];
+    template <class ... Types> constexpr std::size_t
+        packed_layout <Types ...>::payload_alignments [sizeof ... (Types)];
+
+}} // namespace rime::variant_detail
+
+#endif // RIME_DETAIL_PACKED_LAYOUT_HPP_INCLUDED
@@ -18,6 +18,9 @@ limitations under the License.
 \file
 Define a function with a purpose similar to the C++ switch statement.
 However, it is limited to taking classes whose operator() is called.
+It can be implemented with a table of function pointers, a real switch
+statement, or a chain of if statements, optionally preceded by comparisons with
+the indices that are expected most often; see rime/dispatch_policy.hpp.
 
 The contents of this file are in the detail namespace because the interface
 is too limited for general use.
@@ -27,12 +30,33 @@ is too limited for general use.
 #define RIME_DETAIL_SWITCH_HPP_INCLUDED
 
 #include <cassert>
+#include <cstdlib>
+#include <tuple>
+
+#include <boost/preprocessor/repetition/repeat.hpp>
 
 #include "meta/vector.hpp"
 #include "rime/core.hpp"
+#include "rime/dispatch_policy.hpp"
 
 namespace rime { namespace detail {
 
+template <class Type> struct void_for { typedef void type; };
+
+/**
+The class whose code is used for the alternative Choice.
+Alternatives that do exactly the same thing can define a nested type
+canonical_choice to point to one class that does it.
+They then share one instantiation of call_object, and, in a table, one function
+pointer, which keeps the code small.
+*/
+template <class Choice, class Enable = void> struct canonical_choice
+{ typedef Choice type; };
+
+template <class Choice> struct canonical_choice <Choice,
+    typename void_for <typename Choice::canonical_choice>::type>
+{ typedef typename Choice::canonical_choice type; };
+
 template <class Choice, typename Result, typename ... Arguments>
     Result call_object (Arguments && ... arguments)
 {
@@ -41,70 +65,246 @@ template <class Choice, typename Result, typename ... Arguments>
 }
 
 /**
-Helper for switch_ which knows the argument types at construction time.
-It provides a table of function pointers, which the constructor initialises.
-A neater version would use recursion.
-However, by expanding the parameter pack in Choices at once, the length of
-backtraces in error messages becomes bounded.
+Helper for switch_ which knows the argument types at compile time.
+It implements the dispatch with the implementation that Strategy, one of the
+classes in rime::dispatch_policy, indicates.
 */
-template <typename Result, class Arguments, class Choices> struct switch_impl;
+template <class Strategy, typename Result, class Arguments, class Choices>
+    struct switch_impl;
 
+/**
+Implementation that uses a table of function pointers.
+The table is a constant expression, so it is initialised statically: calling
+through it requires no initialisation guard and no first-call set-up.
+Expanding the parameter pack in Choices at once, rather than using recursion,
+keeps the length of backtraces in error messages bounded.
+*/
 template <typename Result, typename ... Arguments, class ... Choices>
-    struct switch_impl <Result, meta::vector <Arguments ...>,
-        meta::vector <Choices ...> >
+    struct switch_impl <dispatch_policy::table, Result,
+        meta::vector <Arguments ...>, meta::vector <Choices ...> >
 {
-    switch_impl()
-    { set_pointers (&functions[0], get_function <Choices>() ...); }
-
     typedef Result (*function_pointer) (Arguments && ...);
 
-    static const std::size_t choice_num
-        = meta::size <meta::vector <Choices ...>>::value;
-    function_pointer functions [choice_num];
+    static const std::size_t choice_num = sizeof ... (Choices);
 
-private:
-    template <class Choice> function_pointer get_function() const
-    { return  &call_object <Choice, Result, Arguments ...>; };
+    static constexpr function_pointer functions [choice_num] =
+        { &call_object <typename canonical_choice <Choices>::type,
+            Result, Arguments ...> ... };
 
-    template <class FirstPointer, class ... OtherPointers>
-        static void set_pointers (function_pointer * destination,
-            FirstPointer first_pointer, OtherPointers ... other_pointers)
-    {
-        *destination = first_pointer;
-        set_pointers (destination + 1, other_pointers ...);
+    static Result call (std::size_t which, Arguments && ... arguments)
+    { return functions [which] (std::forward <Arguments> (arguments) ...); }
+};
+
+// Out-of-class definition is required since call() indexes the table.
+template <typename Result, typename ... Arguments, class ... Choices>
+    constexpr typename switch_impl <dispatch_policy::table, Result,
+        meta::vector <Arguments ...>, meta::vector <Choices ...> >
+        ::function_pointer
+    switch_impl <dispatch_policy::table, Result,
+        meta::vector <Arguments ...>, meta::vector <Choices ...> >
+        ::functions [];
+
+/**
+Call alternative number Index directly.
+If Exists is false, then Index is out of range, and the case is unreachable.
+*/
+template <std::size_t Index, bool Exists,
+    typename Result, class Arguments, class Choices>
+struct switch_case;
+
+template <std::size_t Index,
+    typename Result, typename ... Arguments, class ... Choices>
+struct switch_case <Index, true,
+    Result, meta::vector <Arguments ...>, meta::vector <Choices ...> >
+{
+    typedef typename canonical_choice <typename std::tuple_element <
+        Index, std::tuple <Choices ...>>::type>::type choice;
+
+    static Result call (Arguments && ... arguments) {
+        return call_object <choice, Result, Arguments ...> (
+            std::forward <Arguments> (arguments) ...);
+    }
+};
+
+template <std::size_t Index,
+    typename Result, typename ... Arguments, class ... Choices>
+struct switch_case <Index, false,
+    Result, meta::vector <Arguments ...>, meta::vector <Choices ...> >
+{
+    static Result call (Arguments && ...) {
+        assert (false);
+        std::abort();
+    }
+};
+
+/**
+The number of cases in one switch statement of the switch_statement
+implementation.
+Where there are more alternatives, the default case goes on to another switch
+statement for the next block of alternatives.
+*/
+#define RIME_DETAIL_SWITCH_BLOCK_SIZE 16
+
+template <std::size_t First, bool Exists,
+    typename Result, class Arguments, class Choices>
+struct switch_statement_block;
+
+#define RIME_DETAIL_SWITCH_CASE(z, offset, data) \
+    case offset: \
+        return switch_case <First + offset, \
+                (First + offset < sizeof ... (Choices)), Result, \
+                meta::vector <Arguments ...>, meta::vector <Choices ...> \
+            >::call (std::forward <Arguments> (arguments) ...);
+
+template <std::size_t First,
+    typename Result, typename ... Arguments, class ... Choices>
+struct switch_statement_block <First, true,
+    Result, meta::vector <Arguments ...>, meta::vector <Choices ...> >
+{
+    static const std::size_t next = First + RIME_DETAIL_SWITCH_BLOCK_SIZE;
+
+    static Result call (std::size_t which, Arguments && ... arguments) {
+        switch (which - First) {
+            BOOST_PP_REPEAT (RIME_DETAIL_SWITCH_BLOCK_SIZE,
+                RIME_DETAIL_SWITCH_CASE, ~)
+        default:
+            return switch_statement_block <next, (next < sizeof ... (Choices)),
+                    Result, meta::vector <Arguments ...>,
+                    meta::vector <Choices ...>
+                >::call (which, std::forward <Arguments> (arguments) ...);
+        }
     }
+};
+
+#undef RIME_DETAIL_SWITCH_CASE
 
-    static void set_pointers (function_pointer *) {}
+// Past the last alternative: unreachable.
+template <std::size_t First,
+    typename Result, typename ... Arguments, class ... Choices>
+struct switch_statement_block <First, false,
+    Result, meta::vector <Arguments ...>, meta::vector <Choices ...> >
+{
+    static Result call (std::size_t, Arguments && ...) {
+        assert (false);
+        std::abort();
+    }
+};
+
+#undef RIME_DETAIL_SWITCH_BLOCK_SIZE
+
+/**
+Implementation that uses switch statements with 16 cases each.
+*/
+template <typename Result, typename ... Arguments, class ... Choices>
+    struct switch_impl <dispatch_policy::switch_statement, Result,
+        meta::vector <Arguments ...>, meta::vector <Choices ...> >
+: switch_statement_block <0, true,
+    Result, meta::vector <Arguments ...>, meta::vector <Choices ...> > {};
+
+template <std::size_t Index, bool Last,
+    typename Result, class Arguments, class Choices>
+struct if_chain_link;
+
+template <std::size_t Index,
+    typename Result, typename ... Arguments, class ... Choices>
+struct if_chain_link <Index, false,
+    Result, meta::vector <Arguments ...>, meta::vector <Choices ...> >
+{
+    static Result call (std::size_t which, Arguments && ... arguments) {
+        if (which == Index)
+            return switch_case <Index, true, Result,
+                    meta::vector <Arguments ...>, meta::vector <Choices ...>
+                >::call (std::forward <Arguments> (arguments) ...);
+        else
+            return if_chain_link <Index + 1,
+                    (Index + 2 == sizeof ... (Choices)), Result,
+                    meta::vector <Arguments ...>, meta::vector <Choices ...>
+                >::call (which, std::forward <Arguments> (arguments) ...);
+    }
+};
+
+// The last alternative: no need to compare.
+template <std::size_t Index,
+    typename Result, typename ... Arguments, class ... Choices>
+struct if_chain_link <Index, true,
+    Result, meta::vector <Arguments ...>, meta::vector <Choices ...> >
+{
+    static Result call (std::size_t which, Arguments && ... arguments) {
+        assert (which == Index);
+        return switch_case <Index, true, Result,
+                meta::vector <Arguments ...>, meta::vector <Choices ...>
+            >::call (std::forward <Arguments> (arguments) ...);
+    }
+};
+
+/**
+Implementation that compares the index with each alternative in turn.
+*/
+template <typename Result, typename ... Arguments, class ... Choices>
+    struct switch_impl <dispatch_policy::if_chain, Result,
+        meta::vector <Arguments ...>, meta::vector <Choices ...> >
+: if_chain_link <0, (sizeof ... (Choices) == 1),
+    Result, meta::vector <Arguments ...>, meta::vector <Choices ...> > {};
+
+/**
+Implementation that compares the index with the hot indices in turn, and then
+falls back to the implementation for Strategy.
+*/
+template <class Strategy,
+    typename Result, typename ... Arguments, class ... Choices>
+    struct switch_impl <dispatch_policy::hot_first <Strategy>, Result,
+        meta::vector <Arguments ...>, meta::vector <Choices ...> >
+: switch_impl <Strategy,
+    Result, meta::vector <Arguments ...>, meta::vector <Choices ...> > {};
+
+template <class Strategy, std::size_t First, std::size_t ... Rest,
+    typename Result, typename ... Arguments, class ... Choices>
+    struct switch_impl <dispatch_policy::hot_first <Strategy, First, Rest ...>,
+        Result, meta::vector <Arguments ...>, meta::vector <Choices ...> >
+{
+    static Result call (std::size_t which, Arguments && ... arguments) {
+        if (First < sizeof ... (Choices) && which == First)
+            return switch_case <First, (First < sizeof ... (Choices)), Result,
+                    meta::vector <Arguments ...>, meta::vector <Choices ...>
+                >::call (std::forward <Arguments> (arguments) ...);
+        else
+            return switch_impl <dispatch_policy::hot_first <Strategy, Rest ...>,
+                    Result, meta::vector <Arguments ...>,
+                    meta::vector <Choices ...>
+                >::call (which, std::forward <Arguments> (arguments) ...);
+    }
 };
 
 /**
 A class that functions like a switch statement.
 The cases are defined at compile-time by a meta::vector of classes.
 At run-time, an integer determines which class gets instantiated and called.
+How this is implemented is determined by Policy, a metafunction class from
+namespace rime::dispatch_policy.
 
 This class is optimised to reduce the length of error messages.
 The interface is too basic for exposure to the world at large.
-
-\todo This uses a static switch_impl object inside operator().
-What does this mean for performance?
-Should this be replaced by a big telescoping switch statement?
 */
-template <typename ResultType, class Choices> struct switch_
-: switch_ <ResultType, typename meta::as_vector <Choices>::type> {};
+template <typename ResultType, class Choices,
+    class Policy = dispatch_policy::default_policy>
+struct switch_
+: switch_ <ResultType, typename meta::as_vector <Choices>::type, Policy> {};
 
-template <typename ResultType, typename ... Choices>
-    struct switch_ <ResultType, meta::vector <Choices ...> >
+template <typename ResultType, typename ... Choices, class Policy>
+    struct switch_ <ResultType, meta::vector <Choices ...>, Policy>
 {
+    typedef typename Policy::template apply <sizeof ... (Choices)>::type
+        strategy;
+
     template <typename ... Arguments>
         ResultType operator() (std::size_t which, Arguments && ... arguments)
         const
     {
-        typedef switch_impl <ResultType, meta::vector <Arguments...>,
+        typedef switch_impl <strategy, ResultType, meta::vector <Arguments...>,
             meta::vector <Choices ...> > implementation_type;
-        assert (which < implementation_type::choice_num);
-        static implementation_type implementation;
-        return implementation.functions [which] (
-            std::forward <Arguments> (arguments) ...);
+        assert (which < sizeof ... (Choices));
+        return implementation_type::call (
+            which, std::forward <Arguments> (arguments) ...);
     }
 };
 
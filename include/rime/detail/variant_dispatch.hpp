@@ -39,8 +39,11 @@ being introduced first.
 
 #include "meta/vector.hpp"
 #include "meta/transform.hpp"
+#include "meta/filter.hpp"
 #include "meta/flatten.hpp"
 #include "utility/storage.hpp"
+#include "rime/dispatch_policy.hpp"
+#include "rime/detail/count_dispatch.hpp"
 #include "rime/detail/switch.hpp"
 
 #include "rime/detail/variant_fwd.hpp"
@@ -49,7 +52,9 @@ being introduced first.
 namespace rime {
 
 // Forward definition
-template <typename Function> class visitor;
+template <typename Function,
+    class DispatchPolicy = dispatch_policy::default_policy>
+class visitor;
 
 /**
 Return a function wrapper that determines at compile time what the actual
@@ -101,11 +106,22 @@ This file will go through this process from the inside out.
 1. Convert the argument to its actual type.
 2. Call the actual function.
 3. List all possible combinations of actual types.
+4. Choose the dispatch policy.
 And then, put all this together.
+
+How the linear switch is implemented can be chosen with DispatchPolicy, one of
+the classes in namespace rime::dispatch_policy.
+For example,
+    visit <rime::dispatch_policy::if_chain> (f) (v)
+compares v.which() with each index in turn and can inline the calls to f.
 */
-template <typename Function>
-    inline visitor <Function> visit (Function && function)
-{ return visitor <Function> (std::forward <Function> (function)); }
+template <class DispatchPolicy = dispatch_policy::default_policy,
+    typename Function>
+inline visitor <Function, DispatchPolicy> visit (Function && function)
+{
+    return visitor <Function, DispatchPolicy> (
+        std::forward <Function> (function));
+}
 
 namespace variant_detail {
 
@@ -135,6 +151,29 @@ template <typename Variant, typename Actual>
 convert_to_actual (Variant && v)
 { return rime::get_unsafe <Actual> (std::forward <Variant> (v)); }
 
+/**
+Call a function with arguments that have already been converted to their
+actual types.
+This depends only on the converted types, and not on which variant they came
+from or how they were stored in it.
+For example, an int & stored as int & and one stored as int in a
+variant <int &, int> & are passed in in the same way.
+All recipients that produce the same converted types therefore share one
+instantiation of this, and of the call in it; void alternatives, which are
+left out, share the call with the remaining arguments.
+*/
+template <typename Function, typename ... Arguments> struct dispatch_call {
+    typedef decltype (std::declval <Function>() (
+        std::declval <Arguments>() ...)) result_type;
+
+    result_type operator() (
+        Function && function, Arguments && ... arguments) const
+    {
+        return std::forward <Function> (function) (
+            std::forward <Arguments> (arguments) ...);
+    }
+};
+
 /**
 2. Call the actual function.
 
@@ -202,11 +241,23 @@ template <typename Function, typename ... Arguments,
     I hope that helps!
     */
 
+    /**
+    The call, which is shared between all recipients whose arguments convert
+    to the same types.
+    */
+    typedef dispatch_call <
+        decltype (convert_to_actual <Function, ActualFunction> (
+            std::declval <Function &&>())),
+        decltype (convert_to_actual <Arguments, ActualArguments> (
+            std::declval <Arguments &&>())) ...> call_type;
+
     result_type operator() (
         Function && function, Arguments && ... arguments) const
     {
-        return convert_to_actual <Function, ActualFunction> (
-                std::forward <Function> (function)) (
+        call_type call;
+        return call (
+            convert_to_actual <Function, ActualFunction> (
+                std::forward <Function> (function)),
             convert_to_actual <Arguments, ActualArguments> (
                 std::forward <Arguments> (arguments)) ...);
     }
@@ -342,13 +393,33 @@ public:
     static std::size_t get_index() { return 0; }
 };
 
+/**
+4. Choose the dispatch policy.
+If exactly one of the arguments (including the function) is a variant, then
+the linear index is its which(), so the policy can be adapted to check its
+hot alternatives first; see variant_hot_alternatives.
+Otherwise, DispatchPolicy is used unchanged.
+*/
+template <class DispatchPolicy, class Variants>
+    struct visit_dispatch_policy_impl
+{ typedef DispatchPolicy type; };
+
+template <class DispatchPolicy, class Variant>
+    struct visit_dispatch_policy_impl <DispatchPolicy, meta::vector <Variant>>
+: with_hot_alternatives <DispatchPolicy, Variant> {};
+
+template <class DispatchPolicy, class Arguments> struct visit_dispatch_policy
+: visit_dispatch_policy_impl <DispatchPolicy,
+    typename meta::as_vector <meta::filter <
+        is_variant <boost::mpl::_>, Arguments>>::type> {};
+
 } // namespace variant_detail
 
 /**
 Function wrapper that enables multiple dispatch on its parameters and the
 function itself.
 */
-template <typename Function> class visitor {
+template <typename Function, class DispatchPolicy> class visitor {
     Function function;
 
     /**
@@ -388,9 +459,13 @@ template <typename Function> class visitor {
         result_type operator() (Arguments && ... arguments) const {
             std::size_t which = PossibleActualArguments::get_index (
                 std::forward <Arguments> (arguments) ...);
+            RIME_DETAIL_COUNT_DISPATCH (variant_dispatcher,
+                sizeof ... (PossibleRecipients), which);
             static rime::detail::switch_ <result_type,
                 meta::vector <variant_detail::convert_result <
-                    result_type, PossibleRecipients> ...> > s;
+                    result_type, PossibleRecipients> ...>,
+                typename variant_detail::visit_dispatch_policy <DispatchPolicy,
+                    meta::vector <Arguments ...>>::type> s;
             return s (which, std::forward <Arguments> (arguments) ...);
         }
     };
@@ -28,6 +28,16 @@ namespace rime {
 
 template <typename ... Types> class variant;
 
+template <typename ... Types> class variant_vector;
+
+template <typename ... Types> class variant_ref;
+
+template <typename ... Types> class packed_variant_sequence;
+
+namespace variant_detail {
+    struct variant_ref_access;
+} // namespace variant_detail
+
 template <typename Type> struct is_variant;
 
 template <typename Type> struct variant_types;
@@ -17,6 +17,8 @@ limitations under the License.
 #ifndef RIME_VARIANT_HELPERS_HPP
 #define RIME_VARIANT_HELPERS_HPP
 
+#include <type_traits>
+
 #include <boost/mpl/bool.hpp>
 
 #include "meta/vector.hpp"
@@ -36,6 +38,21 @@ template <typename Type> struct is_variant <Type &> : is_variant <Type> {};
 template <typename... Types>
     struct is_variant <variant <Types...> >
 : boost::mpl::true_ {};
+template <typename... Types>
+    struct is_variant <variant_ref <Types...> >
+: boost::mpl::true_ {};
+
+/**
+Compile-time constant, true iff Type is a rime::variant_ref.
+*/
+template <typename Type> struct is_variant_ref : boost::mpl::false_ {};
+template <typename Type> struct is_variant_ref <Type const>
+: is_variant_ref <Type> {};
+template <typename Type> struct is_variant_ref <Type &>
+: is_variant_ref <Type> {};
+template <typename... Types>
+    struct is_variant_ref <variant_ref <Types...> >
+: boost::mpl::true_ {};
 
 /**
 Meta-function: return list of types that Type can be.
@@ -59,6 +76,22 @@ template <typename ... Types> struct variant_types <variant <Types ...> const>
 template <typename ... Types> struct variant_types <variant <Types ...> const &>
 : variant_types <variant <Types ...> > {};
 
+// A variant_ref <Types ...> refers to an object: get returns a reference.
+template <typename ... Types> struct variant_types <variant_ref <Types ...> >
+{ typedef meta::vector <typename std::add_lvalue_reference <Types>::type ...>
+    type; };
+
+template <typename ... Types> struct variant_types <variant_ref <Types ...> &>
+: variant_types <variant_ref <Types ...> > {};
+
+template <typename ... Types>
+    struct variant_types <variant_ref <Types ...> const>
+: variant_types <variant_ref <Types ...> > {};
+
+template <typename ... Types>
+    struct variant_types <variant_ref <Types ...> const &>
+: variant_types <variant_ref <Types ...> > {};
+
 } // namespace rime
 
 #endif  // RIME_VARIANT_HELPERS_HPP
@@ -22,9 +22,19 @@ operator() and operator[] must be defined inside the class.
 #ifndef RIME_DETAIL_VARIANT_OPERATOR_HPP_INCLUDED
 #define RIME_DETAIL_VARIANT_OPERATOR_HPP_INCLUDED
 
+#include <cstddef>
+#include <type_traits>
+
 #include <boost/mpl/or.hpp>
+#include <boost/mpl/and.hpp>
+#include <boost/mpl/placeholders.hpp>
+
+#include "meta/transform.hpp"
 
 #include "variant_fwd.hpp"
+#include "rime/dispatch_policy.hpp"
+#include "rime/detail/switch.hpp"
+#include "rime/detail/compiler.hpp"
 
 namespace rime {
 
@@ -97,7 +107,109 @@ RIME_VARIANT_DEFINE_UNARY_POSTFIX_OPERATOR(postfix_decrement, --)
 
 /* Binary operators */
 
-#define RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(name, operation) \
+namespace variant_detail {
+
+    /**
+    Apply Operation to the objects of type Actual that both operands contain.
+    */
+    template <class Operation, class Actual, class Dummy = void>
+        struct same_alternative_operation
+    {
+        template <class Left, class Right>
+            auto operator() (Left && left, Right && right) const
+        -> decltype (Operation() (
+            get_unsafe <Actual> (std::forward <Left> (left)),
+            get_unsafe <Actual> (std::forward <Right> (right))))
+        {
+            return Operation() (
+                get_unsafe <Actual> (std::forward <Left> (left)),
+                get_unsafe <Actual> (std::forward <Right> (right)));
+        }
+    };
+
+    // Leave void to the general implementation.
+    template <class Operation, class Dummy>
+        struct same_alternative_operation <Operation, void, Dummy>
+    {
+        template <class Left, class Right>
+            auto operator() (Left && left, Right && right) const
+        -> decltype (visit (Operation()) (
+            std::forward <Left> (left), std::forward <Right> (right)))
+        {
+            return visit (Operation()) (
+                std::forward <Left> (left), std::forward <Right> (right));
+        }
+    };
+
+    /**
+    Apply the binary operator Operation by dispatching on the product of the
+    types that the operands can contain.
+    */
+    template <class Result, class Operation, class Left, class Right>
+        struct apply_binary_operator
+    {
+        static Result call (Left && left, Right && right) {
+            return visit (Operation()) (
+                std::forward <Left> (left), std::forward <Right> (right));
+        }
+    };
+
+    template <class Left, class Right> struct is_same_variant
+    : boost::mpl::and_ <is_variant <Left>, std::is_same <
+        typename std::decay <Left>::type, typename std::decay <Right>::type>>
+    {};
+
+    /**
+    Apply the comparison operator Operation.
+    If the operands are variants of the same type, they mostly contain the
+    same type.
+    This is then checked first, and the call dispatches on only that type.
+    Only if the contained types are different does it dispatch on the product
+    of the types, in a function that is not inlined.
+    */
+    template <class Result, class Operation, class Left, class Right,
+        bool SameVariant = is_same_variant <Left, Right>::value>
+    struct apply_comparison_operator
+    : apply_binary_operator <Result, Operation, Left, Right> {};
+
+    template <class Result, class Operation, class Left, class Right>
+        struct apply_comparison_operator <
+            Result, Operation, Left, Right, true>
+    {
+        typedef typename std::decay <Left>::type variant_type;
+
+        static RIME_DETAIL_NOINLINE Result call_different (
+            Left && left, Right && right)
+        {
+            return apply_binary_operator <Result, Operation, Left, Right>
+                ::call (std::forward <Left> (left),
+                    std::forward <Right> (right));
+        }
+
+        static Result call (Left && left, Right && right) {
+            std::size_t which = left.which();
+            if (RIME_DETAIL_LIKELY (which == right.which())) {
+                typedef meta::transform <same_alternative_operation <
+                        Operation, boost::mpl::_>,
+                    typename variant_types <variant_type>::type>
+                    specialisations;
+                ::rime::detail::switch_ <Result, specialisations,
+                    typename variant_dispatch_policy <variant_type>::type> s;
+                return s (which,
+                    std::forward <Left> (left), std::forward <Right> (right));
+            }
+            return call_different (
+                std::forward <Left> (left), std::forward <Right> (right));
+        }
+    };
+
+} // namespace variant_detail
+
+/*
+Define a binary operator.
+"apply" is the class template in variant_detail that implements it.
+*/
+#define RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(name, operation, apply) \
 namespace variant_detail { \
     struct name { \
         template <typename LeftActual, typename RightActual> \
@@ -126,32 +238,52 @@ template <class LeftVariant, class RightVariant> inline \
             LeftVariant, RightVariant>::type \
     >::type operator operation (LeftVariant && left, RightVariant && right) \
 { \
-    return visit (variant_detail::name()) (std::forward <LeftVariant> (left), \
-        std::forward <RightVariant> (right)); \
+    return variant_detail::apply < \
+            typename variant_detail::name##_result < \
+                LeftVariant, RightVariant>::type, \
+            variant_detail::name, LeftVariant, RightVariant \
+        >::call (std::forward <LeftVariant> (left), \
+            std::forward <RightVariant> (right)); \
 }
 
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(plus, +)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(minus, -)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(times, *)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(divides, /)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(modulo, %)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(plus, +,
+    apply_binary_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(minus, -,
+    apply_binary_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(times, *,
+    apply_binary_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(divides, /,
+    apply_binary_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(modulo, %,
+    apply_binary_operator)
 
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(equal, ==)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(not_equal, !=)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(greater, >)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(less, <)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(greater_equal, >=)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(less_equal, <=)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(equal, ==,
+    apply_comparison_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(not_equal, !=,
+    apply_comparison_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(greater, >,
+    apply_comparison_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(less, <,
+    apply_comparison_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(greater_equal, >=,
+    apply_comparison_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(less_equal, <=,
+    apply_comparison_operator)
 
 // What about short-circuiting?
-//RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(and_, &&)
-//RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(or_, ||)
-
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(logical_and, &)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(logical_or, |)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(logical_xor, ^)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(shift_left, <<)
-RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(shift_right, >>)
+//RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(and_, &&, apply_binary_operator)
+//RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(or_, ||, apply_binary_operator)
+
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(logical_and, &,
+    apply_binary_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(logical_or, |,
+    apply_binary_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(logical_xor, ^,
+    apply_binary_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(shift_left, <<,
+    apply_binary_operator)
+RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR(shift_right, >>,
+    apply_binary_operator)
 
 #undef RIME_VARIANT_DEFINE_BINARY_POSTFIX_OPERATOR
 
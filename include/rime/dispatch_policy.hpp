@@ -0,0 +1,223 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Define policies that decide how a run-time index is turned into a call to one
+of a number of compile-time alternatives.
+This is used for dispatching on the contained type of variants, both in
+rime::visit and inside rime::variant.
+*/
+
+#ifndef RIME_DISPATCH_POLICY_HPP_INCLUDED
+#define RIME_DISPATCH_POLICY_HPP_INCLUDED
+
+#include <cstddef>
+
+#include <type_traits>
+
+#include <boost/mpl/if.hpp>
+
+#include "meta/vector.hpp"
+#include "meta/contains.hpp"
+
+#include "rime/detail/variant_helpers.hpp"
+
+/**
+The dispatch policy that is used when none is given explicitly.
+Define this before including any Rime header to change the default for the
+whole program.
+*/
+#ifndef RIME_DEFAULT_DISPATCH_POLICY
+#  define RIME_DEFAULT_DISPATCH_POLICY ::rime::dispatch_policy::automatic
+#endif
+
+namespace rime {
+
+/**
+This namespace contains metafunction classes that select the implementation
+of dispatch on a run-time index.
+They contain an apply struct with a template parameter \a ChoiceNum, the number
+of alternatives, which has type "type", the implementation to use.
+This is one of \c table, \c switch_statement, or \c if_chain.
+*/
+namespace dispatch_policy {
+
+    /**
+    Call through a constant table of function pointers.
+    This costs an indirect call, which the compiler cannot inline, but its cost
+    does not depend on the number of alternatives.
+    */
+    struct table {
+        template <std::size_t ChoiceNum> struct apply
+        { typedef table type; };
+    };
+
+    /**
+    Use a switch statement whose cases call the alternatives directly, so that
+    they can be inlined.
+    The compiler normally turns this into a jump table.
+    */
+    struct switch_statement {
+        template <std::size_t ChoiceNum> struct apply
+        { typedef switch_statement type; };
+    };
+
+    /**
+    Compare the index with each alternative in turn, and call the alternatives
+    directly, so that they can be inlined.
+    This is fastest for few alternatives, particularly if the first ones are
+    most common.
+    */
+    struct if_chain {
+        template <std::size_t ChoiceNum> struct apply
+        { typedef if_chain type; };
+    };
+
+    /**
+    Use if_chain for up to \a MaxIfChain alternatives, switch_statement for up
+    to \a MaxSwitch alternatives, and table otherwise.
+    The default values are for contained types that are not known to be
+    skewed, as measured by the "uniform" runs of
+    bench/bench-dispatch_policy.cpp.
+    An if_chain then makes on average about half as many comparisons as there
+    are alternatives, and its branches are mispredicted more often the longer
+    it is, so it is used only for up to 4 alternatives.
+    If a few types are much more common than the others, specialise
+    variant_hot_alternatives instead of raising \a MaxIfChain.
+    */
+    template <std::size_t MaxIfChain = 4, std::size_t MaxSwitch = 16>
+        struct by_size
+    {
+        template <std::size_t ChoiceNum> struct apply
+        : boost::mpl::if_c <(ChoiceNum <= MaxIfChain), if_chain,
+            typename boost::mpl::if_c <(ChoiceNum <= MaxSwitch),
+                switch_statement, table>::type> {};
+    };
+
+    struct automatic : by_size<> {};
+
+    /**
+    Compare the index with each of \a HotIndices in turn, and call those
+    alternatives directly, so that they can be inlined.
+    Only for other indices, use the implementation that \a Fallback selects.
+    This is fastest if most of the time, the index is one of the first of
+    \a HotIndices.
+    Indices that are out of range are ignored.
+
+    Normally, this is not used directly; see variant_hot_alternatives.
+    */
+    template <class Fallback, std::size_t ... HotIndices> struct hot_first {
+        template <std::size_t ChoiceNum> struct apply {
+            typedef hot_first <
+                typename Fallback::template apply <ChoiceNum>::type,
+                HotIndices ...> type;
+        };
+    };
+
+    struct default_policy : RIME_DEFAULT_DISPATCH_POLICY {};
+
+} // namespace dispatch_policy
+
+/**
+The types that \a Variant is expected to contain most often, the most common
+first, as a meta::vector.
+By default, this is empty.
+Specialise this, for example from the counts that rime/dispatch_profile.hpp
+records, to make dispatching on the contained type of \a Variant compare
+which() with the indices of these types first, and only then use the normal
+dispatch policy.
+This does not change which() or anything else about the variant.
+
+This is used by variant_dispatch_policy, and by visit if exactly one of the
+arguments (or the function) is a variant.
+\code
+template <> struct rime::variant_hot_alternatives <
+    rime::variant <std::string, double, int>>
+{ typedef meta::vector <int, double> type; };
+\endcode
+*/
+template <class Variant> struct variant_hot_alternatives
+{ typedef meta::vector<> type; };
+
+namespace variant_detail {
+
+    template <class Type, class Types> struct hot_index;
+
+    template <class Type, class ... Rest>
+        struct hot_index <Type, meta::vector <Type, Rest ...>>
+    : std::integral_constant <std::size_t, 0> {};
+
+    template <class Type, class First, class ... Rest>
+        struct hot_index <Type, meta::vector <First, Rest ...>>
+    : std::integral_constant <std::size_t,
+        hot_index <Type, meta::vector <Rest ...>>::value + 1> {};
+
+    template <class Policy, std::size_t Index> struct add_hot_index
+    { typedef dispatch_policy::hot_first <Policy, Index> type; };
+
+    template <class Fallback, std::size_t ... HotIndices, std::size_t Index>
+        struct add_hot_index <
+            dispatch_policy::hot_first <Fallback, HotIndices ...>, Index>
+    {
+        typedef dispatch_policy::hot_first <Fallback, Index, HotIndices ...>
+            type;
+    };
+
+    template <class Policy, class HotTypes, class Types>
+        struct with_hot_types;
+
+    template <class Policy, class Types>
+        struct with_hot_types <Policy, meta::vector<>, Types>
+    { typedef Policy type; };
+
+    template <class Policy, class First, class ... Rest, class Types>
+        struct with_hot_types <Policy, meta::vector <First, Rest ...>, Types>
+    {
+        static_assert (meta::contains <First, Types>::value,
+            "The hot alternatives must be types of the variant.");
+
+        typedef typename add_hot_index <
+            typename with_hot_types <
+                Policy, meta::vector <Rest ...>, Types>::type,
+            hot_index <First, Types>::value>::type type;
+    };
+
+    /**
+    Return Policy, adapted to check the hot alternatives of Variant first, if
+    it has any.
+    */
+    template <class Policy, class Variant> struct with_hot_alternatives
+    : with_hot_types <Policy, typename variant_hot_alternatives <
+            typename std::decay <Variant>::type>::type,
+        typename variant_types <Variant>::type> {};
+
+} // namespace variant_detail
+
+/**
+Dispatch policy that rime::variant uses internally for \a Variant, for
+example to destruct and copy its contents and in its operator().
+By default, this is the default policy, adapted to check the types in
+variant_hot_alternatives <Variant> first.
+Specialise this to use a different policy for one variant type.
+*/
+template <class Variant> struct variant_dispatch_policy
+: variant_detail::with_hot_alternatives <
+    dispatch_policy::default_policy, Variant> {};
+
+} // namespace rime
+
+#endif // RIME_DISPATCH_POLICY_HPP_INCLUDED
@@ -0,0 +1,190 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Count, at run time, how often each alternative is dispatched to.
+
+To decide which types to pass to visit_likely, or which dispatch policy to
+use, it is useful to know which contained types are common at which dispatch
+site.
+If RIME_DISPATCH_PROFILE is defined before any Rime header is included, every
+dispatch in visit, in variant::operator(), and in the destructor of variant
+increments a counter for the site and the index of the alternative.
+Otherwise, no counting code is generated at all, and the Rime headers do not
+include this file.
+
+RIME_DISPATCH_PROFILE must be either defined or not defined in all translation
+units of a program, for example by passing it on the command line.
+Otherwise, inline functions and templates, such as the destructor of a variant,
+have different definitions in different translation units, which violates the
+one-definition rule; the linker then picks one of them, so that some dispatches
+may or may not be counted.
+
+A dispatch site is one instantiation of the code that dispatches: for visit,
+this is the combination of the function type and the argument types.
+The index is the one that is passed to the switch_: for one variant, this is
+which(); for visit with more than one variant, this is the linear index into
+all combinations of types, as explained in detail/variant_dispatch.hpp.
+
+The counters are updated with relaxed atomic operations, so counting is
+thread-safe but the counts that are read while other threads are dispatching
+may not be exactly consistent with each other.
+*/
+
+#ifndef RIME_DISPATCH_PROFILE_HPP_INCLUDED
+#define RIME_DISPATCH_PROFILE_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace rime { namespace dispatch_profile {
+
+/**
+The counts for one dispatch site.
+*/
+struct site_counts {
+    /// A description of the site, normally containing its type.
+    std::string name;
+    /// The number of dispatches to each index.
+    std::vector <std::uint64_t> counts;
+};
+
+namespace detail {
+
+    /**
+    The counters for one site.
+    These are linked into a list, which is only ever added to.
+    */
+    struct site {
+        char const * name;
+        std::size_t size;
+        std::atomic <std::uint64_t> * counts;
+        site * next;
+    };
+
+    inline std::atomic <site *> & first_site() {
+        static std::atomic <site *> first (nullptr);
+        return first;
+    }
+
+    inline void register_site (site & new_site) {
+        std::atomic <site *> & first = first_site();
+        new_site.next = first.load (std::memory_order_relaxed);
+        while (!first.compare_exchange_weak (new_site.next, &new_site,
+            std::memory_order_release, std::memory_order_relaxed))
+        {}
+    }
+
+    /**
+    Return a string that describes the type Site.
+    */
+    template <class Site> inline char const * site_name() {
+#if defined (__GNUC__) || defined (__clang__)
+        return __PRETTY_FUNCTION__;
+#elif defined (_MSC_VER)
+        return __FUNCSIG__;
+#else
+        return "(unknown site)";
+#endif
+    }
+
+    template <class Site, std::size_t ChoiceNum> struct site_with_counts {
+        std::atomic <std::uint64_t> counts [ChoiceNum];
+        site this_site;
+
+        site_with_counts() {
+            for (auto & count : counts)
+                count.store (0, std::memory_order_relaxed);
+            this_site.name = site_name <Site>();
+            this_site.size = ChoiceNum;
+            this_site.counts = counts;
+            register_site (this_site);
+        }
+    };
+
+    template <class Site, std::size_t ChoiceNum>
+        inline void count (std::size_t index)
+    {
+        // Initialisation of a local static is thread-safe.
+        static site_with_counts <Site, ChoiceNum> counts;
+        counts.counts [index].fetch_add (1, std::memory_order_relaxed);
+    }
+
+} // namespace detail
+
+/**
+\return
+    The counts for all sites that have been dispatched from at least once.
+    If RIME_DISPATCH_PROFILE is not defined, this is empty.
+*/
+inline std::vector <site_counts> snapshot() {
+    std::vector <site_counts> result;
+    for (detail::site * current = detail::first_site().load (
+            std::memory_order_acquire);
+        current; current = current->next)
+    {
+        site_counts counts;
+        counts.name = current->name;
+        counts.counts.reserve (current->size);
+        for (std::size_t index = 0; index != current->size; ++ index)
+            counts.counts.push_back (
+                current->counts [index].load (std::memory_order_relaxed));
+        result.push_back (std::move (counts));
+    }
+    return result;
+}
+
+/**
+Set all counts to zero.
+*/
+inline void reset() {
+    for (detail::site * current = detail::first_site().load (
+            std::memory_order_acquire);
+        current; current = current->next)
+    {
+        for (std::size_t index = 0; index != current->size; ++ index)
+            current->counts [index].store (0, std::memory_order_relaxed);
+    }
+}
+
+/**
+Write a histogram of the counts to \a stream: for each site, a line with its
+name, and then, for each index that has been dispatched to, a line with the
+index, the count, and the percentage of the total for the site.
+*/
+inline void dump (std::ostream & stream) {
+    for (site_counts const & counts : snapshot()) {
+        std::uint64_t total = 0;
+        for (std::uint64_t count : counts.counts)
+            total += count;
+        stream << counts.name << ": " << total << '\n';
+        for (std::size_t index = 0; index != counts.counts.size(); ++ index) {
+            if (counts.counts [index] != 0)
+                stream << "    " << index << '\t' << counts.counts [index]
+                    << '\t' << (100. * counts.counts [index] / total)
+                    << "%\n";
+        }
+    }
+}
+
+}} // namespace rime::dispatch_profile
+
+#endif // RIME_DISPATCH_PROFILE_HPP_INCLUDED
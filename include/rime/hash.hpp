@@ -0,0 +1,277 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Hash variants: std::hash for variant, variant_equal_to, and hash_range, which
+hashes a range of variants one type or one run of elements of the same type at
+a time.
+
+The hash of a variant combines which() with std::hash of the contained
+object, so that, for example, variant <int, unsigned> (5) and
+variant <int, unsigned> (5u) hash differently.
+For a variant that contains void, only which() is hashed.
+
+This is not consistent with operator==, which compares the contained objects
+whatever their types are, so that variant <int, unsigned> (5) == 5u.
+(operator== also requires every pair of types to be comparable, which is often
+not the case.)
+The equality that matches the hash is variant_equal_to, which considers two
+variants equal only if they contain the same type and the objects compare
+equal.
+Hashed containers of variants should therefore use, for example,
+\code
+std::unordered_set <Variant, std::hash <Variant>, rime::variant_equal_to>
+\endcode
+*/
+
+#ifndef RIME_HASH_HPP_INCLUDED
+#define RIME_HASH_HPP_INCLUDED
+
+#include <cstddef>
+#include <iterator>
+#include <functional>
+#include <type_traits>
+
+#include <boost/mpl/placeholders.hpp>
+
+#include "meta/vector.hpp"
+#include "meta/transform.hpp"
+
+#include "rime/variant.hpp"
+#include "rime/visit_range.hpp"
+#include "rime/detail/switch.hpp"
+
+namespace rime { namespace variant_detail {
+
+    /**
+    Combine the index of the contained type with the hash of the object.
+    This is the same mixing step as boost::hash_combine.
+    */
+    inline std::size_t combine_hash (std::size_t which, std::size_t hash)
+    { return hash ^ (which + 0x9e3779b9 + (hash << 6) + (hash >> 2)); }
+
+    /**
+    Hash the object of type Actual that the variant contains.
+    */
+    template <class Actual, class Dummy = void> struct hash_contained {
+        typedef typename std::remove_cv <
+            typename std::remove_reference <Actual>::type>::type type;
+
+        template <class Variant> std::size_t operator() (
+            std::size_t which, Variant const & v) const
+        {
+            return combine_hash (which,
+                std::hash <type>() (get_unsafe <Actual> (v)));
+        }
+    };
+
+    template <class Dummy> struct hash_contained <void, Dummy> {
+        template <class Variant> std::size_t operator() (
+            std::size_t which, Variant const &) const
+        { return combine_hash (which, 0); }
+    };
+
+    /**
+    Compare two objects of type Actual that two variants contain.
+    */
+    template <class Actual, class Dummy = void> struct equal_contained {
+        template <class Variant> bool operator() (
+            Variant const & left, Variant const & right) const
+        { return get_unsafe <Actual> (left) == get_unsafe <Actual> (right); }
+    };
+
+    template <class Dummy> struct equal_contained <void, Dummy> {
+        template <class Variant> bool operator() (
+            Variant const &, Variant const &) const
+        { return true; }
+    };
+
+    /**
+    Hash a run of variants that all contain Actual, and write the hashes to
+    the output.
+    The hash function is known at compile time, so the loop is tight.
+    */
+    template <class Actual> struct hash_run {
+        template <class Iterator, class Output>
+            void operator() (std::size_t which,
+                Iterator first, Iterator last, Output result) const
+        {
+            hash_contained <Actual> hash;
+            for (; first != last; ++ first, ++ result)
+                *result = hash (which, *first);
+        }
+    };
+
+    template <class Order, class Types> struct hash_range_impl;
+
+    template <class ... Types>
+        struct hash_range_impl <visit_order::sequential,
+            meta::vector <Types ...>>
+    {
+        template <class Iterator, class Output>
+            static void call (Iterator first, Iterator last, Output result)
+        {
+            typedef typename std::decay <typename
+                std::iterator_traits <Iterator>::reference>::type variant_type;
+            typedef meta::transform <hash_run <boost::mpl::_>,
+                meta::vector <Types ...>> specialisations;
+            ::rime::detail::switch_ <void, specialisations,
+                typename variant_dispatch_policy <variant_type>::type> s;
+
+            while (first != last) {
+                std::size_t which = (*first).which();
+                Iterator run_end = first;
+                do
+                    ++ run_end;
+                while (run_end != last && (*run_end).which() == which);
+                s (which, which, first, run_end, result);
+                result += run_end - first;
+                first = run_end;
+            }
+        }
+    };
+
+    template <class ... Types>
+        struct hash_range_impl <visit_order::grouped, meta::vector <Types ...>>
+    {
+        /**
+        Make one pass over [first, last) for each type, starting with the
+        type with index Index, and hash the elements that contain it.
+        */
+        template <std::size_t Index, class ... Remaining> struct hash_groups;
+
+        template <std::size_t Index, class First, class ... Remaining>
+            struct hash_groups <Index, First, Remaining ...>
+        {
+            template <class Iterator, class Output>
+                static void call (Iterator first, Iterator last, Output result)
+            {
+                hash_contained <First> hash;
+                Output current_result = result;
+                for (Iterator current = first; current != last;
+                        ++ current, ++ current_result)
+                    if ((*current).which() == Index)
+                        *current_result = hash (Index, *current);
+                hash_groups <Index + 1, Remaining ...>::call (
+                    first, last, result);
+            }
+        };
+
+        template <std::size_t Index> struct hash_groups <Index> {
+            template <class Iterator, class Output>
+                static void call (Iterator, Iterator, Output) {}
+        };
+
+        template <class Iterator, class Output>
+            static void call (Iterator first, Iterator last, Output result)
+        { hash_groups <0, Types ...>::call (first, last, result); }
+    };
+
+}} // namespace rime::variant_detail
+
+namespace std {
+
+    /**
+    Hash a variant, with one dispatch on which().
+    Each of the types must have a std::hash specialisation (or be void).
+    */
+    template <class ... Types> struct hash <::rime::variant <Types ...>> {
+        typedef ::rime::variant <Types ...> argument_type;
+        typedef std::size_t result_type;
+
+        std::size_t operator() (argument_type const & v) const {
+            typedef meta::transform <
+                ::rime::variant_detail::hash_contained <boost::mpl::_>,
+                meta::vector <Types ...>> specialisations;
+            ::rime::detail::switch_ <std::size_t, specialisations,
+                typename ::rime::variant_dispatch_policy <argument_type>::type>
+                s;
+            return s (v.which(), v.which(), v);
+        }
+    };
+
+} // namespace std
+
+namespace rime {
+
+/**
+Function object that compares two variants of the same type for equality,
+consistently with std::hash.
+The variants are equal if they contain the same type, and the objects that they
+contain compare equal with operator==; two variants that contain void are equal.
+Only objects of the same type are compared, so each type only needs to be
+equality-comparable with itself.
+*/
+struct variant_equal_to {
+    typedef bool result_type;
+
+    template <class ... Types>
+        bool operator() (variant <Types ...> const & left,
+            variant <Types ...> const & right) const
+    {
+        if (left.which() != right.which())
+            return false;
+        typedef meta::transform <
+            variant_detail::equal_contained <boost::mpl::_>,
+            meta::vector <Types ...>> specialisations;
+        detail::switch_ <bool, specialisations,
+            typename variant_dispatch_policy <variant <Types ...>>::type> s;
+        return s (left.which(), left, right);
+    }
+};
+
+/**
+Compute the hashes of the variants in [first, last) and write them to
+\a result.
+The hash of *(first + i) is written to result [i], and equals the value that
+std::hash would compute for it.
+Calling std::hash on each element in turn causes one unpredictable indirect
+call per element.
+hash_range instead hashes in tight loops in which the hash function is known
+at compile time, so that it can be inlined.
+This does not allocate memory.
+
+\tparam Order
+    visit_order::grouped (the default) to make one pass over the range for
+    each type, and hash the elements that contain it, which helps whatever the
+    order of the types;
+    or visit_order::sequential to dispatch once for each run of consecutive
+    elements that contain the same type, which is fastest when equal types
+    are clustered.
+    The results are the same.
+\param first
+    Random-access iterator to the first element.
+    The value type must be a variant.
+\param last
+    Iterator past the last element.
+\param result
+    Random-access iterator to the start of the output, which must have space
+    for last - first values.
+*/
+template <class Order = visit_order::grouped, class Iterator, class Output>
+    inline void hash_range (Iterator first, Iterator last, Output result)
+{
+    typedef typename std::iterator_traits <Iterator>::reference reference;
+    static_assert (is_variant <reference>::value,
+        "hash_range requires a range of variants.");
+    variant_detail::hash_range_impl <Order,
+        typename variant_types <reference>::type>::call (first, last, result);
+}
+
+} // namespace rime
+
+#endif // RIME_HASH_HPP_INCLUDED
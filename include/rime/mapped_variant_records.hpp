@@ -0,0 +1,131 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Map a file with variant records into memory and view the records in place.
+This uses the POSIX functions open and mmap.
+*/
+
+#ifndef RIME_MAPPED_VARIANT_RECORDS_HPP_INCLUDED
+#define RIME_MAPPED_VARIANT_RECORDS_HPP_INCLUDED
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rime/variant_records.hpp"
+
+namespace rime {
+
+/**
+Read-only memory mapping of a whole file.
+*/
+class mapped_file {
+    void * data_;
+    std::size_t size_;
+
+    static std::system_error error (std::string const & what) {
+        return std::system_error (
+            errno, std::generic_category(), what);
+    }
+
+public:
+    /**
+    Map the file at \a path.
+    \throw std::system_error If the file cannot be opened or mapped.
+    */
+    explicit mapped_file (std::string const & path)
+    : data_ (nullptr), size_ (0)
+    {
+        int descriptor = ::open (path.c_str(), O_RDONLY);
+        if (descriptor == -1)
+            throw error ("Cannot open " + path);
+        struct ::stat status;
+        if (::fstat (descriptor, &status) == -1) {
+            std::system_error e = error ("Cannot read the size of " + path);
+            ::close (descriptor);
+            throw e;
+        }
+        size_ = std::size_t (status.st_size);
+        if (size_ != 0) {
+            data_ = ::mmap (nullptr, size_, PROT_READ, MAP_SHARED,
+                descriptor, 0);
+            if (data_ == MAP_FAILED) {
+                std::system_error e = error ("Cannot map " + path);
+                ::close (descriptor);
+                throw e;
+            }
+        }
+        // The mapping stays valid after the file is closed.
+        ::close (descriptor);
+    }
+
+    mapped_file (mapped_file const &) = delete;
+    mapped_file & operator= (mapped_file const &) = delete;
+
+    mapped_file (mapped_file && that) noexcept
+    : data_ (that.data_), size_ (that.size_)
+    {
+        that.data_ = nullptr;
+        that.size_ = 0;
+    }
+
+    ~mapped_file() {
+        if (data_)
+            ::munmap (data_, size_);
+    }
+
+    /// \return The address of the mapping, which is page-aligned.
+    void const * data() const { return data_; }
+    std::size_t size() const { return size_; }
+};
+
+/**
+File with variant records of Types, mapped into memory.
+The records are read directly from the mapped pages, without copying or
+parsing; only the header is checked when the file is opened.
+*/
+template <class ... Types> class mapped_variant_records
+: public variant_records_view <Types ...>
+{
+    // Keeps the mapping alive while the view is in use.
+    mapped_file file_;
+
+    explicit mapped_variant_records (mapped_file && file)
+    : variant_records_view <Types ...> (file.data(), file.size()),
+        file_ (std::move (file)) {}
+
+public:
+    /**
+    Map the file at \a path.
+    \throw std::system_error If the file cannot be opened or mapped.
+    \throw variant_records_error
+        If the file does not contain complete variant records of Types.
+    */
+    explicit mapped_variant_records (std::string const & path)
+    : mapped_variant_records (mapped_file (path)) {}
+};
+
+} // namespace rime
+
+#endif // RIME_MAPPED_VARIANT_RECORDS_HPP_INCLUDED
@@ -0,0 +1,464 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Define a sequence of variants that stores each element at the exact size of
+its type.
+*/
+
+#ifndef RIME_PACKED_VARIANT_SEQUENCE_HPP_INCLUDED
+#define RIME_PACKED_VARIANT_SEQUENCE_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+#include <boost/utility/enable_if.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/placeholders.hpp>
+
+#include "meta/vector.hpp"
+#include "meta/transform.hpp"
+
+#include "rime/variant.hpp"
+#include "rime/variant_ref.hpp"
+#include "rime/detail/switch.hpp"
+#include "rime/detail/packed_layout.hpp"
+
+namespace rime {
+
+/**
+Sequence of variant <Types...> that stores each element as a tag followed
+directly by the object, at the size and alignment of the type of the object.
+An element whose type is small therefore takes little space, even if one of
+Types is large.
+Elements are appended at the end, and never move, as in a log.
+Memory is allocated in blocks; an element that is larger than a block gets a
+block of its own.
+
+The sequence can be iterated forward.
+The iterators yield a variant_ref to the element in place, which works with
+rime::visit and rime::get.
+visit_each calls a function on every element in order, dispatching directly
+on the tag.
+
+Types cannot contain references.
+*/
+template <class ... Types> class packed_variant_sequence {
+public:
+    typedef variant <Types ...> value_type;
+
+    /// Reference to an element, as yielded by the iterators.
+    typedef variant_ref <Types ...> reference;
+    typedef variant_ref <typename variant_detail::packed_const_element <
+        Types>::type ...> const_reference;
+
+private:
+    typedef variant_detail::variant_base <Types ...> base_type;
+    typedef meta::vector <Types ...> types;
+
+    typedef typename base_type::dispatch_policy_type dispatch_policy_type;
+    typedef variant_detail::packed_layout <Types ...> layout;
+    typedef typename layout::which_type which_type;
+
+    template <typename Type> struct sanity_check {
+        typedef int dummy;
+        static_assert (!std::is_reference <Type>::value,
+            "packed_variant_sequence cannot contain references.");
+    };
+
+    typedef meta::vector <typename sanity_check <Types>::dummy ...>
+        trigger_sanity_check;
+
+    static const std::size_t alignment = layout::alignment;
+
+    /// Unit of memory that blocks are allocated in.
+    typedef typename std::aligned_storage <alignment, alignment>::type unit;
+
+    struct block {
+        std::unique_ptr <unit []> memory;
+        std::size_t capacity;
+        std::size_t used;
+
+        explicit block (std::size_t unit_num)
+        : memory (new unit [unit_num]), capacity (unit_num * sizeof (unit)),
+            used (0) {}
+
+        char * data() const { return reinterpret_cast <char *> (memory.get()); }
+    };
+
+    std::size_t block_size_;
+    std::vector <block> blocks_;
+    std::size_t size_;
+
+    static std::size_t payload_offset (std::size_t which, std::size_t tag)
+    { return layout::payload_offset (which, tag); }
+
+    static std::size_t record_end (std::size_t which, std::size_t tag)
+    { return layout::record_end (which, tag); }
+
+    /**
+    Destruct the object at \a payload.
+    */
+    template <class Type, class Dummy = void> struct destruct_record {
+        void operator() (char const * payload) const {
+            reinterpret_cast <Type *> (const_cast <char *> (payload))
+                ->~Type();
+        }
+    };
+    template <class Dummy> struct destruct_record <void, Dummy>
+    { void operator() (char const *) const {} };
+
+    /**
+    Append a copy of the object at \a payload to \a target.
+    */
+    template <class Type, class Dummy = void> struct copy_record {
+        void operator() (char const * payload,
+            packed_variant_sequence & target) const
+        {
+            target.template emplace_back_as <Type> (
+                *reinterpret_cast <Type const *> (payload));
+        }
+    };
+    template <class Dummy> struct copy_record <void, Dummy> {
+        void operator() (char const *, packed_variant_sequence & target) const
+        { target.template emplace_back_as <void>(); }
+    };
+
+    /**
+    Call a function with the object at \a payload, as an lvalue of type
+    Object, or without arguments if it is void.
+    */
+    template <class Type, class Object, class Dummy = void> struct call_record {
+        template <class Function>
+            void operator() (char const * payload, Function & function) const
+        {
+            function (*reinterpret_cast <Object *> (
+                const_cast <char *> (payload)));
+        }
+    };
+    template <class Object, class Dummy>
+        struct call_record <void, Object, Dummy>
+    {
+        template <class Function>
+            void operator() (char const *, Function & function) const
+        { function(); }
+    };
+
+    /**
+    Call the specialisation in Choices for the type of each record, in order,
+    with the address of its payload and \a arguments.
+    */
+    template <class Choices, class ... Arguments>
+        void for_each_record (Arguments && ... arguments) const
+    {
+        ::rime::detail::switch_ <void, Choices, dispatch_policy_type> s;
+        for (block const & b : blocks_) {
+            std::size_t tag = 0;
+            while (tag != b.used) {
+                std::size_t which = layout::which (b.data() + tag);
+                s (which, b.data() + payload_offset (which, tag), arguments ...);
+                tag = record_end (which, tag);
+            }
+        }
+    }
+
+    /**
+    Make space for a record of type Type at the end of the last block, or in
+    a new block.
+    */
+    template <class Type> void reserve_record() {
+        static const std::size_t which
+            = base_type::template index_of <Type>::value;
+        if (blocks_.empty()
+            || record_end (which, blocks_.back().used)
+                > blocks_.back().capacity)
+        {
+            std::size_t needed = record_end (which, 0);
+            std::size_t bytes = needed > block_size_ ? needed : block_size_;
+            blocks_.emplace_back ((bytes + sizeof (unit) - 1) / sizeof (unit));
+        }
+    }
+
+    /**
+    Construct an element of type Type at the end.
+    The tag is written and the block extended only once the object has been
+    constructed, so that if construction throws, the sequence does not
+    change.
+    */
+    template <class Type, class ... Arguments>
+        void emplace_back_as (Arguments && ... arguments)
+    {
+        static const std::size_t which
+            = base_type::template index_of <Type>::value;
+        reserve_record <Type>();
+        block & last = blocks_.back();
+        try {
+            construct_payload <Type> (
+                last.data() + payload_offset (which, last.used),
+                std::forward <Arguments> (arguments) ...);
+        } catch (...) {
+            // Iteration relies on blocks never being empty.
+            if (last.used == 0)
+                blocks_.pop_back();
+            throw;
+        }
+        *reinterpret_cast <which_type *> (last.data() + last.used)
+            = which_type (which);
+        last.used = record_end (which, last.used);
+        ++ size_;
+    }
+
+    template <class Type, class ... Arguments>
+        static typename boost::disable_if <std::is_void <Type>>::type
+        construct_payload (char * payload, Arguments && ... arguments)
+    { new (payload) Type (std::forward <Arguments> (arguments) ...); }
+
+    template <class Type>
+        static typename boost::enable_if <std::is_void <Type>>::type
+        construct_payload (char *) {}
+
+    /**
+    Append the contents of a variant.
+    This is called when it turns out, at run time, that that_variant
+    contains an object of type Actual.
+    */
+    template <typename Actual, typename Dummy = void>
+        struct append_containing
+    {
+        template <class ThatVariant> void operator() (
+            packed_variant_sequence & sequence, ThatVariant && that_variant)
+            const
+        {
+            sequence.append (get_unsafe <Actual> (
+                std::forward <ThatVariant> (that_variant)));
+        }
+    };
+    template <typename Dummy> struct append_containing <void, Dummy> {
+        template <class ThatVariant> void operator() (
+            packed_variant_sequence & sequence, ThatVariant && that_variant)
+            const
+        {
+            get_unsafe <void> (std::forward <ThatVariant> (that_variant));
+            sequence.template emplace_back_as <void>();
+        }
+    };
+
+    void destruct_all() {
+        if (!variant_detail::all_of <variant_detail::packed_payload <Types>
+                ::trivially_destructible ...>::value)
+            for_each_record <meta::vector <destruct_record <Types> ...>>();
+    }
+
+public:
+    /**
+    Forward iterator over the elements of the sequence.
+    Dereferencing it yields a variant_ref, by value.
+    Appending an element invalidates all iterators.
+    */
+    template <class Reference> class iterator_base
+    : public std::iterator <std::forward_iterator_tag, value_type,
+        std::ptrdiff_t, void, Reference>
+    {
+        friend class packed_variant_sequence;
+        template <class OtherReference> friend class iterator_base;
+
+        block const * block_;
+        std::size_t tag_;
+
+        iterator_base (block const * b, std::size_t tag)
+        : block_ (b), tag_ (tag) {}
+
+        std::size_t which() const {
+            return layout::which (block_->data() + tag_);
+        }
+
+    public:
+        iterator_base() : block_ (nullptr), tag_ (0) {}
+
+        /// Convert an iterator into a const_iterator.
+        template <class OtherReference>
+            iterator_base (iterator_base <OtherReference> const & that,
+                typename boost::enable_if <std::is_convertible <
+                    OtherReference, Reference>>::type * = 0)
+        : block_ (that.block_), tag_ (that.tag_) {}
+
+        Reference operator*() const {
+            std::size_t which = this->which();
+            return variant_detail::variant_ref_access::make <Reference> (
+                block_->data() + payload_offset (which, tag_), which);
+        }
+
+        iterator_base & operator++() {
+            tag_ = record_end (which(), tag_);
+            // Blocks are never empty, so one step is enough.
+            if (tag_ == block_->used) {
+                ++ block_;
+                tag_ = 0;
+            }
+            return *this;
+        }
+
+        iterator_base operator++ (int) {
+            iterator_base result = *this;
+            ++ *this;
+            return result;
+        }
+
+        template <class OtherReference>
+            bool operator== (iterator_base <OtherReference> const & that) const
+        { return block_ == that.block_ && tag_ == that.tag_; }
+
+        template <class OtherReference>
+            bool operator!= (iterator_base <OtherReference> const & that) const
+        { return !(*this == that); }
+    };
+
+    typedef iterator_base <reference> iterator;
+    typedef iterator_base <const_reference> const_iterator;
+
+    /**
+    \param block_size
+        The size in bytes of the blocks that memory is allocated in.
+    */
+    explicit packed_variant_sequence (std::size_t block_size = 4096)
+    : block_size_ (block_size), size_ (0) {}
+
+    packed_variant_sequence (packed_variant_sequence const & that)
+    : block_size_ (that.block_size_), size_ (0)
+    {
+        try {
+            that.template for_each_record <
+                meta::vector <copy_record <Types> ...>> (*this);
+        } catch (...) {
+            destruct_all();
+            throw;
+        }
+    }
+
+    packed_variant_sequence (packed_variant_sequence && that) noexcept
+    : block_size_ (that.block_size_), blocks_ (std::move (that.blocks_)),
+        size_ (that.size_)
+    {
+        that.blocks_.clear();
+        that.size_ = 0;
+    }
+
+    packed_variant_sequence & operator= (packed_variant_sequence const &)
+        = delete;
+
+    ~packed_variant_sequence() { destruct_all(); }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /**
+    \return The number of bytes used by the elements, including their tags
+    and padding, but not the unused space at the end of the blocks.
+    */
+    std::size_t bytes_used() const {
+        std::size_t result = 0;
+        for (block const & b : blocks_)
+            result += b.used;
+        return result;
+    }
+
+    void clear() {
+        destruct_all();
+        blocks_.clear();
+        size_ = 0;
+    }
+
+    /**
+    Append an element that is not a variant.
+    This selects the type to store in the same way as the constructor of
+    variant <Types...>.
+    */
+    template <typename Actual>
+        typename boost::disable_if <is_variant <Actual>>::type
+        append (Actual && actual,
+            // Trigger assertion here already.
+            int = typename base_type::template conversion_for <Actual>
+                ::assert_unambiguous::dummy())
+    {
+        typedef typename base_type::template conversion_for <Actual>
+            ::numbered_candidates numbered_candidates;
+        typedef typename meta::first <numbered_candidates>::type
+            interpretation;
+        emplace_back_as <typename mpl::second <interpretation>::type> (
+            std::forward <Actual> (actual));
+    }
+
+    /**
+    Append the contents of a variant.
+    Each type that the variant can contain must be convertible to exactly one
+    of Types.
+    */
+    template <typename ThatVariant>
+        typename boost::enable_if <is_variant <ThatVariant>>::type
+        append (ThatVariant && that,
+            int = typename base_type::template conversion_for_contained_types <
+                ThatVariant>::dummy())
+    {
+        typedef meta::transform <append_containing <boost::mpl::_>,
+            typename variant_types <ThatVariant>::type> specialisations;
+        ::rime::detail::switch_ <void, specialisations, dispatch_policy_type>
+            s;
+        s (that.which(), *this, std::forward <ThatVariant> (that));
+    }
+
+    /**
+    Construct an element of type \a Type at the end from \a arguments.
+    */
+    template <class Type, class ... Arguments>
+        typename boost::enable_if <meta::contains <Type, types>>::type
+        emplace_back (Arguments && ... arguments)
+    { emplace_back_as <Type> (std::forward <Arguments> (arguments) ...); }
+
+    iterator begin() { return iterator (blocks_.data(), 0); }
+    iterator end() { return iterator (blocks_.data() + blocks_.size(), 0); }
+
+    const_iterator begin() const
+    { return const_iterator (blocks_.data(), 0); }
+    const_iterator end() const
+    { return const_iterator (blocks_.data() + blocks_.size(), 0); }
+
+    /**
+    Call \a function with every element, in order, as an lvalue reference to
+    the object in place, or without arguments if the element is void.
+    This dispatches once per element, directly on the tag.
+    */
+    template <class Function> void visit_each (Function && function) {
+        for_each_record <meta::vector <call_record <Types, Types> ...>> (
+            function);
+    }
+
+    template <class Function> void visit_each (Function && function) const {
+        for_each_record <meta::vector <call_record <Types,
+            typename variant_detail::packed_const_element <Types>::type> ...>
+            > (function);
+    }
+};
+
+} // namespace rime
+
+#endif // RIME_PACKED_VARIANT_SEQUENCE_HPP_INCLUDED
@@ -0,0 +1,287 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Write variants to a binary stream and read them back.
+
+A variant is written as the index of its type, in the smallest unsigned
+integer that fits, followed by the object, as written by
+serialization_codec.
+For trivially copyable types, this is the bytes of the object, which are
+read back directly into the storage of the variant, without a temporary and
+without allocating memory.
+Numbers are written in the byte order of the machine.
+
+Pointers are rejected at compile time, since the addresses they hold mean
+nothing when they are read back; a struct that contains pointers cannot be
+detected, so do not serialise such types as their bytes.
+bool is written as one byte, 0 or 1, and other values are rejected when
+reading.
+Enumerations are read as the bytes of their underlying type, without checking
+that the value is one of the enumerators; specialise serialization_codec to
+check this.
+
+The output can be any object with a member function write (char const *,
+std::size_t), like std::ostream.
+The input can be any object with a member function read (char *,
+std::size_t) whose result converts to false if not all bytes could be read,
+like std::istream.
+*/
+
+#ifndef RIME_SERIALIZE_HPP_INCLUDED
+#define RIME_SERIALIZE_HPP_INCLUDED
+
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <boost/utility/enable_if.hpp>
+#include <boost/integer.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/placeholders.hpp>
+
+#include "meta/vector.hpp"
+#include "meta/transform.hpp"
+
+#include "rime/variant.hpp"
+#include "rime/detail/switch.hpp"
+
+namespace rime {
+
+/**
+Exception that is thrown when the input ends early or does not contain a
+serialised variant.
+*/
+class serialization_error : public std::runtime_error {
+public:
+    explicit serialization_error (char const * message)
+    : std::runtime_error (message) {}
+};
+
+/**
+Read exactly \a size bytes from \a input into \a data.
+\throw serialization_error If that is not possible.
+*/
+template <class Input> inline void read_bytes (
+    Input & input, char * data, std::size_t size)
+{
+    if (!input.read (data, size))
+        throw serialization_error ("Serialised variant: input ended early");
+}
+
+/**
+Codec that writes an object, which must be trivially copyable, as its bytes.
+deserialize reads objects with this codec, or a codec derived from it,
+directly into the variant.
+*/
+template <class Type> struct byte_codec {
+    template <class Output>
+        static void write (Output & output, Type const & object)
+    { output.write (reinterpret_cast <char const *> (&object), sizeof (Type)); }
+
+    template <class Input> static void read_into (Input & input, void * memory)
+    { read_bytes (input, static_cast <char *> (memory), sizeof (Type)); }
+};
+
+namespace variant_detail {
+
+    template <class Type> struct is_pointer_like
+    : boost::mpl::bool_ <std::is_pointer <Type>::value
+        || std::is_member_pointer <Type>::value> {};
+
+} // namespace variant_detail
+
+/**
+Define how objects of type \a Type are written and read.
+By default, trivially copyable types other than pointers are written as their
+bytes.
+For other types, specialise this with two static member functions:
+    template <class Output> static void write (Output &, Type const &);
+    template <class Input> static Type read (Input &);
+read should throw serialization_error if the input is not valid.
+*/
+template <class Type, class Enable = void> struct serialization_codec {
+    static_assert (!variant_detail::is_pointer_like <Type>::value,
+        "Pointers cannot be serialised: "
+        "the addresses would be meaningless when read back.");
+    static_assert (std::is_trivially_copyable <Type>::value,
+        "Specialise rime::serialization_codec for this type.");
+};
+
+template <class Type> struct serialization_codec <Type,
+    typename boost::enable_if_c <std::is_trivially_copyable <Type>::value
+        && !variant_detail::is_pointer_like <Type>::value>::type>
+: byte_codec <Type> {};
+
+/**
+Write bool as one byte, 0 or 1, and reject any other value when reading, since
+a bool with any other bytes has undefined behaviour.
+*/
+template <> struct serialization_codec <bool> : byte_codec <bool> {
+    template <class Output>
+        static void write (Output & output, bool const & object)
+    {
+        char byte = object ? 1 : 0;
+        output.write (&byte, 1);
+    }
+
+    template <class Input> static void read_into (Input & input, void * memory)
+    {
+        char byte;
+        read_bytes (input, &byte, 1);
+        if (byte != 0 && byte != 1)
+            throw serialization_error ("Serialised variant: invalid bool");
+        new (memory) bool (byte == 1);
+    }
+};
+
+namespace variant_detail {
+
+    /**
+    Compile-time constant that is true iff objects of type Type can be read
+    directly into the storage of a variant.
+    */
+    template <class Type> struct is_byte_serialised
+    : std::is_base_of <byte_codec <Type>, serialization_codec <Type>> {};
+
+    template <> struct is_byte_serialised <void> : boost::mpl::false_ {};
+
+    template <class Types> struct serialization_tag;
+
+    template <class ... Types> struct serialization_tag <meta::vector <Types ...>>
+    {
+        typedef typename boost::uint_value_t <sizeof ... (Types)>::least
+            type;
+    };
+
+    /**
+    Write the object of type Actual that the variant contains.
+    */
+    template <class Actual, class Dummy = void> struct write_contained {
+        template <class Output, class Variant>
+            void operator() (Output & output, Variant const & v) const
+        {
+            typedef typename std::remove_cv <
+                typename std::remove_reference <Actual>::type>::type type;
+            serialization_codec <type>::write (output, get_unsafe <Actual> (v));
+        }
+    };
+
+    template <class Dummy> struct write_contained <void, Dummy> {
+        template <class Output, class Variant>
+            void operator() (Output &, Variant const &) const {}
+    };
+
+    /**
+    Read an object of type Actual and return a Variant that contains it.
+    */
+    template <class Variant, class Actual, class Enable = void>
+        struct read_contained
+    {
+        template <class Input> Variant operator() (Input & input) const {
+            typedef typename std::remove_cv <Actual>::type type;
+            return Variant (in_place_type <Actual>(),
+                serialization_codec <type>::read (input));
+        }
+    };
+
+    /**
+    Fill the storage of a variant with an object of type Type from the
+    input.
+    */
+    template <class Type, class Input> struct fill_from_input {
+        Input & input;
+
+        void operator() (void * memory) const
+        { serialization_codec <Type>::read_into (input, memory); }
+    };
+
+    template <class Variant, class Actual> struct read_contained <
+        Variant, Actual, typename boost::enable_if <
+            is_byte_serialised <typename std::remove_cv <Actual>::type>
+        >::type>
+    {
+        template <class Input> Variant operator() (Input & input) const {
+            typedef typename std::remove_cv <Actual>::type type;
+            return Variant (construct_tag <from_bytes <Actual>>(),
+                fill_from_input <type, Input> { input });
+        }
+    };
+
+    template <class Variant> struct read_contained <Variant, void> {
+        template <class Input> Variant operator() (Input &) const
+        { return Variant (in_place_type <void>()); }
+    };
+
+} // namespace variant_detail
+
+/**
+Write \a v to \a output: the index of the type of its contents, and then
+the contents.
+\a v can be a variant of references or a variant_ref; the object it refers to
+is written.
+*/
+template <class Output, class Variant>
+    inline typename boost::enable_if <is_variant <Variant>>::type
+    serialize (Output & output, Variant const & v)
+{
+    typedef typename variant_types <Variant>::type types;
+    typedef typename variant_detail::serialization_tag <types>::type tag_type;
+
+    tag_type tag = tag_type (v.which());
+    output.write (reinterpret_cast <char const *> (&tag), sizeof (tag));
+
+    typedef meta::transform <
+        variant_detail::write_contained <boost::mpl::_>, types>
+        specialisations;
+    ::rime::detail::switch_ <void, specialisations,
+        typename variant_dispatch_policy <
+            typename std::decay <Variant>::type>::type> s;
+    s (v.which(), output, v);
+}
+
+/**
+Read a variant of type \a Variant from \a input, as written by serialize.
+The contained object is constructed in place.
+\throw serialization_error
+    If the input ends early, or the index of the type is out of range.
+*/
+template <class Variant, class Input> inline Variant deserialize (Input & input)
+{
+    static_assert (is_variant <Variant>::value,
+        "deserialize can only read variants.");
+    typedef typename variant_types <Variant>::type types;
+    typedef typename variant_detail::serialization_tag <types>::type tag_type;
+
+    tag_type tag;
+    read_bytes (input, reinterpret_cast <char *> (&tag), sizeof (tag));
+    if (std::size_t (tag) >= meta::size <types>::value)
+        throw serialization_error ("Serialised variant: invalid type index");
+
+    typedef meta::transform <
+        variant_detail::read_contained <Variant, boost::mpl::_>, types>
+        specialisations;
+    ::rime::detail::switch_ <Variant, specialisations,
+        typename variant_dispatch_policy <Variant>::type> s;
+    return s (tag, input);
+}
+
+} // namespace rime
+
+#endif // RIME_SERIALIZE_HPP_INCLUDED
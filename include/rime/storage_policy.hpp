@@ -0,0 +1,98 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Define policies that decide where rime::variant stores each of its
+alternatives: inside the variant, or on the heap.
+*/
+
+#ifndef RIME_STORAGE_POLICY_HPP_INCLUDED
+#define RIME_STORAGE_POLICY_HPP_INCLUDED
+
+#include <cstddef>
+#include <memory>
+
+#include <boost/mpl/if.hpp>
+
+#include "rime/boxed.hpp"
+
+namespace rime {
+
+/**
+This namespace contains metafunction classes that decide how rime::variant
+stores each alternative.
+They contain an apply struct with a template parameter \a Stored, the type
+that would be stored in the variant, which has type "type", the type to store
+instead.
+This is either \a Stored itself or a rime::boxed <Stored, ...>.
+
+Whatever the policy, the types of the variant remain the same, so get, visit
+and the constructors of the variant do not change.
+*/
+namespace storage_policy {
+
+    /**
+    Store all alternatives inside the variant.
+    The variant is as large as its largest alternative.
+    */
+    struct in_place {
+        template <class Stored> struct apply
+        { typedef Stored type; };
+    };
+
+    /**
+    Store alternatives that are larger than \a MaxSize bytes on the heap, in
+    a rime::boxed, and the rest inside the variant.
+    This keeps the variant small if one alternative is much larger than the
+    others, and rare.
+    Constructing, copying, or moving a variant that contains a boxed
+    alternative allocates memory.
+    Moving it moves the object into a new box, so that the source variant still
+    holds a valid object, as it would without the box.
+
+    \tparam Allocator
+        The allocator to use for the boxed alternatives.
+        It is rebound to each of the boxed types, and default-constructed
+        whenever an alternative is boxed.
+        For rime::arena_allocator, this means that the current arena is used:
+        see rime::arena_scope.
+        Copying or moving a boxed alternative uses the allocator of the source
+        box instead.
+    */
+    template <std::size_t MaxSize, class Allocator = std::allocator <void>>
+        struct box_larger_than
+    {
+        template <class Stored> struct apply
+        : boost::mpl::if_c <(sizeof (Stored) > MaxSize),
+            boxed <Stored, typename std::allocator_traits <Allocator>
+                ::template rebind_alloc <Stored>>,
+            Stored> {};
+    };
+
+} // namespace storage_policy
+
+/**
+Storage policy that rime::variant uses for \a Variant.
+By default, all alternatives are stored in place.
+Specialise this to use a different policy for one variant type.
+*/
+template <class Variant> struct variant_storage_policy
+{ typedef storage_policy::in_place type; };
+
+} // namespace rime
+
+#endif // RIME_STORAGE_POLICY_HPP_INCLUDED
@@ -22,12 +22,17 @@ Define a variant type, similar to boost::variant.
 #ifndef RIME_VARIANT_HPP_INCLUDED
 #define RIME_VARIANT_HPP_INCLUDED
 
+#include <cstring>
+#include <cstdint>
+#include <memory>
 #include <utility>
 #include <stdexcept>
+#include <tuple>
 
 #include <type_traits>
 
 #include <boost/utility/enable_if.hpp>
+#include <boost/integer.hpp>
 
 #include <boost/mpl/int.hpp>
 #include <boost/mpl/sizeof.hpp>
@@ -36,11 +41,16 @@ Define a variant type, similar to boost::variant.
 #include <boost/mpl/greater_equal.hpp>
 #include <boost/mpl/less_equal.hpp>
 #include <boost/mpl/and.hpp>
+#include <boost/mpl/or.hpp>
 #include <boost/mpl/not.hpp>
+#include <boost/mpl/if.hpp>
 #include <boost/mpl/empty.hpp>
 #include <boost/mpl/size.hpp>
 #include <boost/mpl/placeholders.hpp>
 #include <boost/mpl/eval_if.hpp>
+#include <boost/mpl/identity.hpp>
+#include <boost/mpl/pair.hpp>
+#include <boost/mpl/size_t.hpp>
 #include <boost/mpl/bind.hpp>
 
 #include "utility/storage.hpp"
@@ -55,6 +65,10 @@ Define a variant type, similar to boost::variant.
 #include "meta/max_element.hpp"
 #include "rime/merge_types.hpp"
 #include "rime/core.hpp"
+#include "rime/dispatch_policy.hpp"
+#include "rime/detail/count_dispatch.hpp"
+#include "rime/storage_policy.hpp"
+#include "rime/boxed.hpp"
 
 #include "rime/detail/switch.hpp"
 
@@ -71,6 +85,36 @@ struct bad_get : std::runtime_error {
         "get (variant<...>) called with a type that was not contained") {}
 };
 
+/**
+Tag to construct a variant in place with an object of type \a Type, from the
+arguments passed in after the tag.
+For example:
+
+    rime::variant <int, std::string> v (
+        rime::in_place_type <std::string>(), 5, 'a');
+*/
+template <class Type> struct in_place_type {};
+
+/**
+Tag to construct a variant in place with an object of the type with index
+\a Index in the list of types, from the arguments passed in after the tag.
+*/
+template <std::size_t Index> struct in_place_index {};
+
+/**
+Compile-time constant that is true iff \a Variant stores the index of the
+contained type in the low bits of the address of the object it refers to,
+so that it takes no more space than a pointer.
+This is false by default; specialise it to opt in.
+This is only possible for a variant whose types are all lvalue references (or
+void), to types whose alignment leaves enough low bits free to hold the index.
+For example, a variant <node_a &, node_b &, node_c &> needs the alignment of
+each of the node types to be at least 4.
+The requirement on the alignment is checked when a reference is stored, so
+the types can be incomplete where the variant type is used.
+*/
+template <class Variant> struct variant_tag_in_pointer : boost::mpl::false_ {};
+
 namespace variant_detail {
 
     /**
@@ -100,6 +144,1076 @@ namespace variant_detail {
 
 } // namespace variant_detail
 
+namespace variant_detail {
+
+    /**
+    Tags that select the constructor of variant_base.
+    construct_tag <from_value> constructs from an object of one of the
+    contained types; construct_tag <from_void> constructs as void;
+    construct_tag <from_variant> constructs from another variant;
+    construct_tag <from_in_place <Type>> constructs an object of type Type
+    from the arguments; construct_tag <from_bytes <Type>> lets a function
+    fill the storage for a trivially copyable Type with bytes.
+    The tags are passed down through variant_destructor_base and
+    variant_copy_base, so that the contents are constructed in the innermost
+    base class.
+    That way, if construction throws, no destructor is run on uninitialised
+    memory.
+    */
+    struct from_value {};
+    struct from_void {};
+    struct from_variant {};
+    template <class Type> struct from_in_place {};
+    template <class Type> struct from_bytes {};
+    template <class Kind> struct construct_tag {};
+
+    template <class Type> struct is_in_place_tag : boost::mpl::false_ {};
+    template <class Type> struct is_in_place_tag <in_place_type <Type>>
+    : boost::mpl::true_ {};
+    template <std::size_t Index> struct is_in_place_tag <in_place_index <Index>>
+    : boost::mpl::true_ {};
+
+    template <bool ... Values> struct bool_sequence {};
+
+    /**
+    Compile-time constant that is true iff all of Values are true.
+    */
+    template <bool ... Values> struct all_of
+    : std::is_same <bool_sequence <Values ..., true>,
+        bool_sequence <true, Values ...>> {};
+
+    /**
+    The type that Variant stores for an alternative of type Type.
+    This is normally ::utility::storage::store <Type>::type, but the storage
+    policy for Variant can replace it by a boxed.
+    */
+    template <class Type, class Variant> struct stored_alternative
+    : variant_storage_policy <Variant>::type::template apply <
+        typename ::utility::storage::store <Type>::type> {};
+
+    template <class Variant> struct stored_alternative <void, Variant>
+    { typedef void type; };
+
+    template <class ... Types> class variant_base;
+
+    struct no_interpretation;
+
+    /**
+    The type that an object of type Type becomes when a Variant that contains
+    it is copied or moved from Source, which is a reference to Variant.
+    This is not always Type: for example, if the variant can contain both int
+    and int const &, then copying from a Variant const & converts the int into
+    int const &.
+    */
+    template <class Type, class Variant, class Source = Variant const &>
+        struct copied_alternative;
+
+    template <class Type, class ... Types, class Source>
+        struct copied_alternative <Type, variant <Types ...>, Source>
+    {
+        typedef typename variant_base <Types ...>::template conversion_for <
+                typename ::utility::storage::get <Type, Source>::type
+            >::numbered_candidates candidates;
+
+        typedef typename mpl::second <typename boost::mpl::eval_if <
+                meta::empty <candidates>,
+                boost::mpl::identity <boost::mpl::pair <
+                    boost::mpl::size_t <0>, no_interpretation>>,
+                meta::first <candidates>
+            >::type>::type type;
+    };
+
+    template <class Type, class Variant, class Source = Variant const &>
+        struct is_copied_as_itself
+    : std::is_same <
+        typename copied_alternative <Type, Variant, Source>::type, Type> {};
+
+    /**
+    Compile-time constant that is true iff Variant can copy an object of
+    type Type by copying the bytes of its storage and the index.
+    This requires not only that Type is trivially copyable, but also that
+    copying from a variant const & does not change the contained type.
+    */
+    template <class Type, class Variant> struct is_trivially_copied_alternative
+    : boost::mpl::and_ <
+        boost::mpl::bool_ <!std::is_rvalue_reference <Type>::value>,
+        std::is_trivially_copyable <
+            typename stored_alternative <Type, Variant>::type>,
+        is_copied_as_itself <Type, Variant>> {};
+
+    template <class Variant>
+        struct is_trivially_copied_alternative <void, Variant>
+    : boost::mpl::true_ {};
+
+    template <class Type, class Variant>
+        struct is_trivially_destructed_alternative
+    : std::is_trivially_destructible <
+        typename stored_alternative <Type, Variant>::type> {};
+
+    template <class Variant>
+        struct is_trivially_destructed_alternative <void, Variant>
+    : boost::mpl::true_ {};
+
+    /**
+    Compile-time constant that is true iff the storage policy of Variant puts
+    alternatives of type Type in a boxed.
+    This is false if Type is itself a boxed: then Variant stores it like any
+    other type.
+    */
+    template <class Type, class Variant> struct is_boxed_alternative
+    : boost::mpl::bool_ <!std::is_same <
+        typename stored_alternative <Type, Variant>::type,
+        typename ::utility::storage::store <Type>::type>::value> {};
+
+    template <class Variant> struct is_boxed_alternative <void, Variant>
+    : boost::mpl::false_ {};
+
+    /**
+    Compile-time constant that is true iff moving an object of type Type from
+    one Variant into another cannot throw.
+    References are stored as pointers, which can always be copied.
+    Boxed alternatives are moved into a new box, which may throw.
+    */
+    template <class Type, class Variant> struct is_nothrow_moved_alternative
+    : boost::mpl::bool_ <std::is_reference <Type>::value
+        || (!is_boxed_alternative <Type, Variant>::value
+            && std::is_nothrow_move_constructible <
+                typename stored_alternative <Type, Variant>::type>::value)> {};
+
+    template <class Variant> struct is_nothrow_moved_alternative <void, Variant>
+    : boost::mpl::true_ {};
+
+    template <class Type, class Variant>
+        struct is_nothrow_destructed_alternative
+    : std::is_nothrow_destructible <
+        typename stored_alternative <Type, Variant>::type> {};
+
+    template <class Variant>
+        struct is_nothrow_destructed_alternative <void, Variant>
+    : boost::mpl::true_ {};
+
+    /**
+    Constant table that maps the index of a type in one variant to the index
+    of a type in another.
+    */
+    template <class Index, std::size_t ... Values> struct index_table {
+        static constexpr Index values [sizeof ... (Values)]
+            = { Index (Values) ... };
+    };
+
+    template <class Index, std::size_t ... Values>
+        constexpr Index index_table <Index, Values ...>::values
+            [sizeof ... (Values)];
+
+    /**
+    \return The smallest power of two that is at least \a number.
+    */
+    constexpr std::size_t round_up_to_power_of_two (std::size_t number,
+        std::size_t power = 1)
+    {
+        return power >= number ? power
+            : round_up_to_power_of_two (number, power * 2);
+    }
+
+    template <class Type> struct can_tag_in_pointer
+    : std::is_lvalue_reference <Type> {};
+
+    template <> struct can_tag_in_pointer <void> : boost::mpl::true_ {};
+
+    /**
+    Hold the index of the contained type and the storage for the object.
+    This is the normal layout, with the index and the storage separate.
+    Depending on the storage policy, some alternatives are stored in a boxed,
+    which holds the object on the heap.
+    */
+    template <bool TagInPointer, class ... Types> class variant_data;
+
+    template <class ... Types> class variant_data <false, Types ...> {
+    protected:
+        /**
+        The smallest unsigned integer type that can hold the index of any of the
+        types.
+        This keeps variants of small types small: a variant <char, bool> takes
+        two bytes.
+        */
+        typedef typename boost::uint_value_t <sizeof ... (Types)>::least
+            which_type;
+
+        which_type which_;
+
+        // Set up storage size and alignment
+        typedef typename meta::filter <
+                mpl::not_ <std::is_same <boost::mpl::_, void> >,
+                meta::vector <Types ...>
+            > types_without_void;
+
+        typedef typename meta::as_vector <meta::transform <
+                stored_alternative <boost::mpl::_, variant <Types ...>>,
+                types_without_void
+            >>::type stored_types;
+
+        typedef typename utility::aligned_union <stored_types>::type
+            storage_type;
+        storage_type storage;
+
+        void * memory() { return &storage; }
+        void const * memory() const { return &storage; }
+
+        static const bool any_boxed = !all_of <
+            !is_boxed_alternative <Types, variant <Types ...>>::value ...
+            >::value;
+
+        /**
+        Construct an object of type Type in the storage, or in a new box.
+        The index must be set separately.
+        */
+        template <class Type, class ... Arguments>
+            void store_object (Arguments && ... arguments)
+        {
+            typedef typename stored_alternative <Type, variant <Types ...>>
+                ::type stored_type;
+
+            static_assert (sizeof (stored_type) <= sizeof (storage_type),
+                "Sanity check: there should be enough space to contain type");
+            static_assert (alignof (stored_type) <= alignof (storage_type),
+                "Sanity check: the alignment should be great enough for type");
+
+            store_stored <stored_type> (typename
+                is_boxed_alternative <Type, variant <Types ...>>::type(),
+                std::forward <Arguments> (arguments) ...);
+        }
+
+        template <class StoredType, class ... Arguments>
+            void store_stored (boost::mpl::false_, Arguments && ... arguments)
+        {
+            new (memory()) StoredType (
+                std::forward <Arguments> (arguments) ...);
+        }
+
+        template <class Box, class ... Arguments>
+            void store_stored (boost::mpl::true_, Arguments && ... arguments)
+        {
+            new (memory()) Box (std::allocator_arg,
+                typename Box::allocator_type(),
+                std::forward <Arguments> (arguments) ...);
+        }
+
+        /**
+        \return A pointer to the object of type
+        ::utility::storage::store <Type>::type, which is in the storage, or,
+        if it is boxed, on the heap.
+        */
+        template <class Type> void * object_memory()
+        { return object_memory <Type> (typename is_boxed_alternative <Type,
+            variant <Types ...>>::type()); }
+
+        template <class Type> void const * object_memory() const
+        {
+            return const_cast <variant_data *> (this)
+                ->template object_memory <Type>();
+        }
+
+        template <class Type> void * object_memory (boost::mpl::false_)
+        { return memory(); }
+
+        template <class Type> void * object_memory (boost::mpl::true_) {
+            typedef typename stored_alternative <Type, variant <Types ...>>
+                ::type box_type;
+            return std::addressof (static_cast <box_type *> (memory())->get());
+        }
+
+        template <class Type, class Dummy = void> struct object_memory_of {
+            void * operator() (variant_data & data) const
+            { return data.object_memory <Type>(); }
+        };
+        template <class Dummy> struct object_memory_of <void, Dummy> {
+            void * operator() (variant_data & data) const
+            { return data.memory(); }
+        };
+
+        /**
+        \return A pointer to the contained object, of whichever type it is.
+        */
+        void const * object_memory() const {
+            if (!any_boxed)
+                return memory();
+            ::rime::detail::switch_ <void *,
+                meta::vector <object_memory_of <Types> ...>,
+                typename variant_dispatch_policy <variant <Types ...>>::type>
+                s;
+            return s (which(), *const_cast <variant_data *> (this));
+        }
+
+        /**
+        Destruct the object of type Type, or its box.
+        */
+        template <class Type> void destroy_object() {
+            typedef typename stored_alternative <Type, variant <Types ...>>
+                ::type stored_type;
+            static_cast <stored_type *> (memory())->~stored_type();
+        }
+
+        void set_which (std::size_t index) { which_ = which_type (index); }
+
+    public:
+        std::size_t which() const { return which_; }
+    };
+
+    /**
+    Hold the address of the object referred to and the index of its type in
+    one word: the index goes in the low bits of the address, which are zero
+    because of the alignment of the object.
+    */
+    template <class ... Types> class variant_data <true, Types ...> {
+        static_assert (all_of <can_tag_in_pointer <Types>::value ...>::value,
+            "Only variants of lvalue references can store the index of the "
+            "type in the pointer.");
+
+    protected:
+        typedef typename boost::uint_value_t <sizeof ... (Types)>::least
+            which_type;
+
+        static constexpr std::uintptr_t mask
+            = round_up_to_power_of_two (sizeof ... (Types)) - 1;
+
+        std::uintptr_t bits_;
+
+        variant_data() : bits_ (0) {}
+
+        /**
+        Store the address of the object that \a argument refers to.
+        The index must be set separately.
+        */
+        template <class Type, class Argument>
+            void store_object (Argument && argument)
+        {
+            typedef typename std::remove_reference <Type>::type object_type;
+            static_assert (alignof (object_type) > mask,
+                "The alignment of the type referred to is not great enough "
+                "to store the index of the type in the pointer.");
+            Type object = std::forward <Argument> (argument);
+            bits_ = reinterpret_cast <std::uintptr_t> (std::addressof (object));
+        }
+
+        void set_which (std::size_t index)
+        { bits_ = (bits_ & ~mask) | std::uintptr_t (index); }
+
+        void * pointer() const
+        { return reinterpret_cast <void *> (bits_ & ~mask); }
+
+    public:
+        std::size_t which() const { return std::size_t (bits_ & mask); }
+    };
+
+    template <class ... Types>
+        constexpr std::uintptr_t variant_data <true, Types ...>::mask;
+
+    /**
+    Compile-time constant that is true iff Variant, which may be a reference,
+    stores the index in the pointer.
+    */
+    template <class Variant> struct is_tag_in_pointer_variant
+    : variant_tag_in_pointer <typename std::decay <Variant>::type> {};
+
+    /**
+    Hold the index and the storage of a variant <Types...> and implement
+    construction and destruction of the contents.
+    This does not define any special member functions: that is left to the
+    derived classes variant_copy_base and variant_destructor_base, which do so
+    only if the contained types require it.
+    This makes variant <Types...> trivially copyable and trivially
+    destructible where possible.
+    */
+    template <class ... Types> class variant_base
+    : public variant_data <variant_tag_in_pointer <variant <Types ...>>::value,
+        Types ...>
+    {
+        // Allow access to the storage of other variants for remap.
+        template <class ... OtherTypes> friend class variant_base;
+        // Allow the containers and copied_alternative to use conversion_for.
+        template <class Type, class Variant, class Source>
+            friend struct copied_alternative;
+        template <class ... OtherTypes> friend class ::rime::variant_vector;
+        template <class ... OtherTypes>
+            friend class ::rime::packed_variant_sequence;
+        // Allow variant_ref to refer to the contents.
+        template <class ... OtherTypes> friend class ::rime::variant_ref;
+
+    public:
+        typedef meta::vector <Types...> types;
+        typedef typename meta::as_vector <typename meta::enumerate <types
+            >::type>::type numbered_types;
+
+        /**
+        Find the index of type Actual amongst the possible types of this
+        variant.
+        */
+        template <typename Actual> struct index_of {
+            typedef meta::filter <std::is_same <mpl::second <mpl::_>, Actual>,
+                numbered_types> candidates;
+
+            typedef typename meta::first <candidates>::type index_and_type;
+
+            static_assert (std::is_same <
+                typename mpl::second <index_and_type>::type, Actual>::value,
+                "Sanity check: should have found Actual");
+
+            static const std::size_t value
+                = mpl::first <index_and_type>::type::value;
+        };
+
+    protected:
+        template <typename Type> struct sanity_check {
+            typedef int dummy;
+
+            static_assert (!is_variant <Type>::value,
+                "variant<...> cannot contain a variant<..>.");
+
+            typedef typename meta::as_vector <meta::filter <
+                    std::is_same <Type, boost::mpl::_>, types>>::type
+                duplicate_types;
+
+            static_assert (meta::size <duplicate_types>::value == 1,
+                "Type can only appear in the list of variant types once");
+        };
+
+        typedef meta::vector <typename sanity_check <Types>::dummy ...>
+            trigger_sanity_check;
+
+        typedef typename variant_dispatch_policy <variant <Types ...>>::type
+            dispatch_policy_type;
+
+        static const bool tag_in_pointer
+            = variant_tag_in_pointer <variant <Types ...>>::value;
+        typedef variant_data <tag_in_pointer, Types ...> data_type;
+
+        typedef typename data_type::which_type which_type;
+
+        /**
+        Find the best match for Actual.
+        This produces a list of equally-likely candidates, in "candidates".
+        If this list is empty, a static assertion is triggered.
+        Use assert_unambiguous::dummy (a type that evaluates to int) as soon as
+        possible in the call stack to trigger that static assertion and one for
+        an ambiguous conversion.
+        */
+        template <typename Actual> struct conversion_for {
+
+            // Match the second type of meta::vector <Index, Type>
+            typedef mpl::second <mpl::_> _;
+
+            typedef typename find_candidates <
+                Actual, numbered_types,
+                // Go through matches one by one:
+                // Exact match
+                std::is_same <_, Actual>,
+                // Remove reference from Actual
+                std::is_same <_,
+                    typename std::remove_reference <Actual>::type >,
+                // Remove reference from Actual and remove const-qualification
+                std::is_same <std::remove_const <_>,
+                    typename std::remove_const <
+                        typename std::remove_reference <Actual>::type>::type >,
+                // Convertible in general?
+                boost::mpl::and_ <std::is_convertible <Actual, _>,
+                    boost::mpl::not_ <std::is_reference <_> > >
+            >::type numbered_candidates;
+
+            static const bool conversion_possible =
+                (meta::size <numbered_candidates>::value >= 1);
+
+            static_assert (conversion_possible,
+                "No conversion to variant <...> found. "
+                "For details, see the type: "
+                "rime::variant_detail::variant_base <...>"
+                "::conversion_for <(type passed in)>.");
+
+            /**
+            This class encapsulates an assertion similar to the one above.
+            It is in a class so that the error message shows the candidate
+            targets that are being considered.
+
+            The assertion is phrased as <= 1 so that either the one above is
+            triggered, or the one above, so as to not clutter the compiler
+            output even more.
+            */
+            template <typename Candidates>
+                struct assert_unambiguous_conversion
+            {
+                typedef int dummy;
+                static_assert (meta::size <Candidates>::value <= 1,
+                    "The conversion to the variant type is ambiguous: "
+                    "multiple types are equally good. "
+                    "For details, see the type: "
+                    "rime::variant_detail::variant_base <...>"
+                    "::conversion_for <(type passed in)>"
+                    "::assert_unambiguous_conversion <"
+                    "meta::vector <(possible candidates)>>."
+                    );
+            };
+
+            // For a clearer error message
+            typedef typename meta::as_vector <meta::transform <
+                mpl::second <mpl::_>, numbered_candidates>>::type candidates;
+
+            typedef assert_unambiguous_conversion <candidates>
+                assert_unambiguous;
+        };
+
+        /**
+        Find the best match for the contained types in OtherVariant.
+        This can only be used to trigger early static assertions when
+        converting from variant types.
+        Use dummy (a type that evaluates to int) as soon as possible in the call
+        stack to trigger a compiler error.
+        */
+        template <typename OtherVariant,
+            class ContainedTypes = typename variant_types <OtherVariant>::type>
+        struct conversion_for_contained_types;
+
+        template <typename OtherVariant, typename ... ContainedTypes>
+            struct conversion_for_contained_types <
+                OtherVariant, meta::vector <ContainedTypes...>>
+        {
+            template <typename ... Arguments> struct int_ { typedef int type; };
+
+            typedef typename int_ <typename conversion_for <typename
+                ::utility::storage::get <
+                ContainedTypes, OtherVariant &&>::type>::
+                assert_unambiguous::dummy...>::type dummy;
+        };
+
+        /**
+        Construct from another type.
+        The other type should not be a variant, but instead a type extracted
+        from it.
+        This function compiles happily even if the conversion is ambiguous.
+        This keeps the compiler errors from being cluttered.
+        However, by using conversion_for, a static assertion should be
+        triggered.
+
+        There is another version of this below for the case when no conversion
+        is found at all.
+        This is just, again, because of the jumbled compiler errors this would
+        generate.
+        */
+        template <typename Actual, typename NumberedCandidates
+            = typename conversion_for <Actual>::numbered_candidates>
+        void construct (Actual && actual, typename
+            boost::disable_if <meta::empty <NumberedCandidates>>::type * = 0)
+        {
+            typedef typename meta::first <NumberedCandidates>::type
+                interpretation;
+
+            static const std::size_t index =
+                mpl::first <interpretation>::type::value;
+            typedef typename mpl::second <interpretation>::type type;
+
+            // Copy-construct or move-construct as type "type"
+            this->template store_object <type> (std::forward <Actual> (actual));
+            this->set_which (index);
+        }
+
+        /**
+        Construct from a type when this is impossible.
+        Since this is impossible, this is not implemented.
+        Therefore, it does not produce compiler errors, which reduces clutter.
+        */
+        template <typename Actual, typename NumberedCandidates
+            = typename conversion_for <Actual>::numbered_candidates>
+        void construct (Actual && actual, typename
+            boost::enable_if <meta::empty <NumberedCandidates>>::type * = 0);
+
+        /**
+        Construct an object of type Type, which must be one of the types,
+        directly in the storage, from \a arguments.
+        The index is set only once the object has been constructed.
+        */
+        template <class Type, class ... Arguments>
+            typename boost::disable_if <std::is_void <Type>>::type
+            construct_in_place (Arguments && ... arguments)
+        {
+            this->template store_object <Type> (
+                std::forward <Arguments> (arguments) ...);
+            this->set_which (index_of <Type>::value);
+        }
+
+        template <class Type>
+            typename boost::enable_if <std::is_void <Type>>::type
+            construct_in_place()
+        { construct_void(); }
+
+        void construct_void() {
+            static_assert (meta::contains <void, types>::value,
+                "Attempt to void-construct a variant "
+                "that cannot contain a void value. "
+                "This is caused by calling the nullary constructor "
+                "or by copy-constructing from a variant that can contain "
+                "void.");
+
+            this->set_which (index_of <void>::value);
+            // Nothing needs to be stored.
+        }
+
+        explicit variant_base (construct_tag <from_void>) { construct_void(); }
+
+        template <class Actual>
+            variant_base (construct_tag <from_value>, Actual && actual)
+        { construct (std::forward <Actual> (actual)); }
+
+        template <class ThatVariant>
+            variant_base (construct_tag <from_variant>, ThatVariant && that)
+        { construct_from_other_variant (std::forward <ThatVariant> (that)); }
+
+        template <class Type, class ... Arguments>
+            variant_base (construct_tag <from_in_place <Type>>,
+                Arguments && ... arguments)
+        {
+            static_assert (meta::contains <Type, types>::value,
+                "In-place construction of a variant with a type that it "
+                "cannot contain.");
+            construct_in_place <Type> (
+                std::forward <Arguments> (arguments) ...);
+        }
+
+        template <class Type, class Fill>
+            variant_base (construct_tag <from_bytes <Type>>, Fill && fill)
+        {
+            static_assert (meta::contains <Type, types>::value,
+                "Construction of a variant from bytes of a type that it "
+                "cannot contain.");
+            static_assert (std::is_trivially_copyable <Type>::value,
+                "Only trivially copyable types can be constructed from bytes.");
+            construct_from_bytes <Type> (fill, typename
+                is_boxed_alternative <Type, variant <Types ...>>::type());
+        }
+
+        /**
+        Call \a fill with the address of the storage for an object of type
+        Type, and set the index.
+        Since Type is trivially copyable, filling the storage with the bytes
+        of an object creates it.
+        If the storage policy puts Type in a box, the box is constructed
+        first, and destructed if \a fill throws.
+        */
+        template <class Type, class Fill>
+            void construct_from_bytes (Fill & fill, boost::mpl::false_)
+        {
+            fill (this->template object_memory <Type>());
+            this->set_which (index_of <Type>::value);
+        }
+
+        template <class Type, class Fill>
+            void construct_from_bytes (Fill & fill, boost::mpl::true_)
+        {
+            this->template store_object <Type>();
+            try {
+                fill (this->template object_memory <Type>());
+            } catch (...) {
+                this->template destroy_object <Type>();
+                throw;
+            }
+            this->set_which (index_of <Type>::value);
+        }
+
+        /**
+        Perform copy construction.
+        This is called when it turns out, at run time, that that_variant
+        contains an object of type Actual.
+        */
+        template <typename Actual, typename Dummy = void>
+            struct construct_from_variant_containing
+        {
+            template <class ThatVariant> void operator() (
+                variant_base & this_variant, ThatVariant && that_variant/*,
+                // Trigger assertion here already.
+                // This keeps the backtrace in the compiler error shortish.
+                int = conversion_for <Actual>::assert_unambiguous::dummy()*/)
+                const
+            {
+                // If Actual is boxed, this moves the object into a new box,
+                // so that that_variant still holds a valid object.
+                this_variant.construct (get_unsafe <Actual> (
+                    std::forward <ThatVariant> (that_variant)));
+            }
+        };
+        template <typename Dummy>
+            struct construct_from_variant_containing <void, Dummy>
+        {
+            template <class ThatVariant> void operator() (
+                variant_base & this_variant, ThatVariant && that_variant) const
+            {
+                // Assert that that_variant contains void.
+                get_unsafe <void> (std::forward <ThatVariant> (that_variant));
+                this_variant.construct_void();
+            }
+        };
+
+        /**
+        Copy the storage and the index from a variant of the same type.
+        */
+        struct copy_storage {
+            void operator() (variant_base & this_variant,
+                variant_base const & that_variant) const
+            {
+                std::memcpy (this_variant.memory(), that_variant.memory(),
+                    sizeof (typename data_type::storage_type));
+                this_variant.set_which (that_variant.which());
+            }
+        };
+
+        /**
+        Copy or move the box of the boxed alternative Actual from a variant of
+        the same type.
+        The new box gets its allocator from the box of that variant, rather
+        than a default-constructed one.
+        */
+        template <typename Actual, typename Dummy = void>
+            struct construct_from_same_box
+        {
+            typedef typename stored_alternative <Actual, variant <Types ...>>
+                ::type box_type;
+
+            // Copy: the copy constructor of the box selects the allocator.
+            void operator() (variant_base & this_variant,
+                variant_base const & that_variant) const
+            {
+                new (this_variant.memory()) box_type (
+                    *static_cast <box_type const *> (that_variant.memory()));
+                this_variant.set_which (that_variant.which());
+            }
+
+            // Move: move the object into a new box from the same allocator,
+            // so that that_variant still holds a valid object.
+            void operator() (variant_base & this_variant,
+                variant_base && that_variant) const
+            {
+                box_type & that_box =
+                    *static_cast <box_type *> (that_variant.memory());
+                new (this_variant.memory()) box_type (std::allocator_arg,
+                    that_box.get_allocator(), std::move (that_box.get()));
+                this_variant.set_which (that_variant.which());
+            }
+        };
+
+        /**
+        Perform copy or move construction from ThatVariant, a reference to a
+        variant of the same type, which contains an object of type Actual.
+        All alternatives that can be copied as bytes share one recipient,
+        copy_storage, instead of having one each.
+        That requires that the contained type does not change, for copies
+        from any kind of reference.
+        Boxed alternatives use construct_from_same_box.
+        */
+        template <typename Actual, typename ThatVariant>
+            struct construct_from_same_variant_containing
+        : boost::mpl::if_ <is_boxed_alternative <Actual, variant <Types ...>>,
+            construct_from_same_box <Actual>,
+            construct_from_variant_containing <Actual>>::type
+        {
+            typedef typename boost::mpl::if_ <boost::mpl::and_ <
+                    boost::mpl::bool_ <!tag_in_pointer
+                        && !std::is_void <Actual>::value>,
+                    is_trivially_copied_alternative <
+                        Actual, variant <Types ...>>,
+                    is_copied_as_itself <
+                        Actual, variant <Types ...>, ThatVariant &&>>,
+                copy_storage, construct_from_same_variant_containing
+            >::type canonical_choice;
+        };
+
+        /**
+        Find the type that ThatType in ThatVariant is converted to, and
+        whether that conversion can be done by copying the bytes.
+        That is the case if the type does not change and it is trivially
+        copyable, and neither variant stores it in a box.
+        */
+        template <class ThatType, class ThatVariant> struct remap_alternative
+        {
+            typedef typename conversion_for <typename ::utility::storage::get <
+                ThatType, ThatVariant &&>::type>::numbered_candidates
+                candidates;
+
+            // If there is no candidate, then an assertion will have been
+            // triggered; prevent extra errors.
+            typedef typename boost::mpl::eval_if <meta::empty <candidates>,
+                    boost::mpl::identity <boost::mpl::pair <
+                        boost::mpl::size_t <0>, no_interpretation>>,
+                    meta::first <candidates>
+                >::type interpretation;
+
+            static const bool possible = std::is_same <
+                    typename mpl::second <interpretation>::type, ThatType
+                >::value
+                && std::is_trivially_copyable <
+                    typename ::utility::storage::store <ThatType>::type>::value
+                && !is_boxed_alternative <ThatType,
+                    typename std::decay <ThatVariant>::type>::value
+                && !is_boxed_alternative <ThatType, variant <Types ...>>::value;
+
+            static const std::size_t index
+                = mpl::first <interpretation>::type::value;
+        };
+
+        template <class ThatVariant>
+            struct remap_alternative <void, ThatVariant>
+        {
+            static const bool possible = true;
+            static const std::size_t index = index_of <void>::value;
+        };
+
+        /**
+        Decide whether converting from ThatVariant can be done by copying the
+        storage and looking up the new index in a table.
+        This is possible if every type that ThatVariant can contain is
+        trivially copyable and is converted into the same type.
+        ThatVariant must be a variant with the normal layout, and so must this.
+        */
+        template <class ThatVariant,
+            class ThatTypes = typename variant_types <ThatVariant>::type>
+        struct remap;
+
+        template <class ThatVariant, class ... ThatTypes>
+            struct remap <ThatVariant, meta::vector <ThatTypes ...>>
+        {
+            typedef variant_base <ThatTypes ...> that_base;
+
+            static const bool possible = !tag_in_pointer
+                && std::is_same <typename std::decay <ThatVariant>::type,
+                    variant <ThatTypes ...>>::value
+                && !variant_tag_in_pointer <variant <ThatTypes ...>>::value
+                && all_of <
+                    remap_alternative <ThatTypes, ThatVariant>::possible ...
+                    >::value;
+
+            typedef index_table <which_type,
+                remap_alternative <ThatTypes, ThatVariant>::index ...> table;
+        };
+
+    public:
+        /**
+        Compile-time constant that is true iff constructing this variant from
+        ThatVariant, a reference to another variant, copies the storage and
+        looks up the new index in a table, rather than dispatching on the
+        contained type.
+        */
+        template <class ThatVariant> struct converts_by_copying_storage
+        : boost::mpl::bool_ <remap <ThatVariant>::possible> {};
+
+    protected:
+        template <typename ThatVariant>
+            void construct_from_other_variant (ThatVariant && that,
+                // Trigger assertion here.
+                int = typename conversion_for_contained_types <ThatVariant>
+                    ::dummy())
+        {
+            construct_from_other_variant (std::forward <ThatVariant> (that),
+                boost::mpl::bool_ <remap <ThatVariant>::possible>());
+        }
+
+        /**
+        Convert from another variant by copying its storage and looking up the
+        index in a constant table.
+        */
+        template <typename ThatVariant>
+            void construct_from_other_variant (ThatVariant && that,
+                boost::mpl::true_)
+        {
+            typedef remap <ThatVariant> remap_type;
+            typedef typename remap_type::that_base that_base;
+            static_assert (sizeof (typename that_base::storage_type)
+                    <= sizeof (typename data_type::storage_type),
+                "Sanity check: there should be enough space to contain all "
+                "types of the other variant.");
+
+            std::memcpy (this->memory(),
+                static_cast <that_base const &> (that).memory(),
+                sizeof (typename that_base::storage_type));
+            this->set_which (remap_type::table::values [that.which()]);
+        }
+
+        /**
+        Convert from another variant by calling the constructor for the type
+        that it contains.
+        */
+        template <typename ThatVariant>
+            void construct_from_other_variant (ThatVariant && that,
+                boost::mpl::false_)
+        {
+            /*
+            This constructs an object of type
+                construct_from_variant_containing <Actual>,
+            and calls it with (*this, that).
+            */
+            construct_from_other_variant (std::forward <ThatVariant> (that),
+                boost::mpl::false_(), std::is_same <
+                    typename std::decay <ThatVariant>::type,
+                    variant <Types ...>>());
+        }
+
+        template <typename ThatVariant>
+            void construct_from_other_variant (ThatVariant && that,
+                boost::mpl::false_, std::false_type)
+        {
+            typedef meta::transform <
+                    construct_from_variant_containing <boost::mpl::_>,
+                    typename variant_types <ThatVariant>::type
+                > specialisations;
+            ::rime::detail::switch_ <
+                void, specialisations, dispatch_policy_type> s;
+            s (that.which(), *this, std::forward <ThatVariant> (that));
+        }
+
+        // Copy or move from a variant of the same type.
+        template <typename ThatVariant>
+            void construct_from_other_variant (ThatVariant && that,
+                boost::mpl::false_, std::true_type)
+        {
+            typedef meta::transform <
+                    construct_from_same_variant_containing <
+                        boost::mpl::_, ThatVariant>,
+                    types
+                > specialisations;
+            ::rime::detail::switch_ <
+                void, specialisations, dispatch_policy_type> s;
+            s (that.which(), *this, std::forward <ThatVariant> (that));
+        }
+
+        /**
+        Destruct the object that "this" contains.
+        This is called when it turns out, at run time, that "this" contains an
+        object of type Actual.
+        */
+        template <typename Actual, typename Dummy = void> struct destruct {
+            // Alternatives that need no destruction share one recipient.
+            typedef typename boost::mpl::if_ <
+                is_trivially_destructed_alternative <
+                    Actual, variant <Types ...>>,
+                destruct <void>, destruct>::type canonical_choice;
+
+            void operator() (variant_base & this_variant) const
+            { this_variant.template destroy_object <Actual>(); }
+        };
+        // void is not stored and does not need to be destructed.
+        template <typename Dummy> struct destruct <void, Dummy>
+        { void operator() (variant_base &) const {}; };
+
+        void destruct_content() {
+            destruct_content (boost::mpl::bool_ <all_of <
+                is_trivially_destructed_alternative <Types, variant <Types ...>
+                    >::value ...>::value>());
+        }
+
+        // Nothing needs to be destructed.
+        void destruct_content (boost::mpl::true_) {}
+
+        void destruct_content (boost::mpl::false_) {
+            /*
+            This constructs an object of type destruct <Actual>,
+            and calls it with *this.
+            */
+            typedef meta::transform <destruct <boost::mpl::_>, types>
+                specialisations;
+            RIME_DETAIL_COUNT_DISPATCH (
+                variant_base, sizeof ... (Types), this->which());
+            ::rime::detail::switch_ <
+                void, specialisations, dispatch_policy_type> s;
+            s (this->which(), *this);
+        }
+    };
+
+    /**
+    Base class of variant that defines the copy and move constructors, unless
+    the contained types can all be copied trivially, in which case the
+    implicit ones are trivial.
+    */
+    template <bool Trivial, class ... Types> class variant_copy_base;
+
+    template <class ... Types> class variant_copy_base <true, Types ...>
+    : public variant_base <Types ...>
+    {
+    protected:
+        template <class Kind, class ... Arguments>
+            variant_copy_base (construct_tag <Kind> tag,
+                Arguments && ... arguments)
+        : variant_base <Types ...> (
+            tag, std::forward <Arguments> (arguments) ...) {}
+    };
+
+    template <class ... Types> class variant_copy_base <false, Types ...>
+    : public variant_base <Types ...>
+    {
+        typedef variant <Types ...> derived_type;
+    protected:
+        template <class Kind, class ... Arguments>
+            variant_copy_base (construct_tag <Kind> tag,
+                Arguments && ... arguments)
+        : variant_base <Types ...> (
+            tag, std::forward <Arguments> (arguments) ...) {}
+
+        // "that" is always part of a fully constructed variant.
+        variant_copy_base (variant_copy_base const & that)
+        : variant_base <Types ...> (construct_tag <from_variant>(),
+            static_cast <derived_type const &> (that)) {}
+
+        /**
+        Move constructor.
+        This is noexcept if none of the contained types can throw when moved,
+        so that, for example, std::vector moves variants when it reallocates,
+        instead of copying them.
+        */
+        variant_copy_base (variant_copy_base && that)
+            noexcept (all_of <is_nothrow_moved_alternative <Types,
+                derived_type>::value ...>::value)
+        : variant_base <Types ...> (construct_tag <from_variant>(),
+            static_cast <derived_type &&> (that)) {}
+    };
+
+    /**
+    Base class of variant that defines the destructor, unless the contained
+    types all have trivial destructors.
+    */
+    template <bool Trivial, class ... Types> class variant_destructor_base;
+
+    template <class ... Types> class variant_destructor_base <true, Types ...>
+    : public variant_copy_base <
+        variant_tag_in_pointer <variant <Types ...>>::value
+        || all_of <is_trivially_copied_alternative <Types,
+            variant <Types ...>>::value ...>::value, Types ...>
+    {
+        typedef variant_copy_base <
+            variant_tag_in_pointer <variant <Types ...>>::value
+            || all_of <is_trivially_copied_alternative <Types,
+                variant <Types ...>>::value ...>::value, Types ...>
+            base_type;
+    protected:
+        template <class Kind, class ... Arguments>
+            variant_destructor_base (construct_tag <Kind> tag,
+                Arguments && ... arguments)
+        : base_type (tag, std::forward <Arguments> (arguments) ...) {}
+    };
+
+    template <class ... Types> class variant_destructor_base <false, Types ...>
+    : public variant_copy_base <false, Types ...>
+    {
+        typedef variant_copy_base <false, Types ...> base_type;
+    protected:
+        template <class Kind, class ... Arguments>
+            variant_destructor_base (construct_tag <Kind> tag,
+                Arguments && ... arguments)
+        : base_type (tag, std::forward <Arguments> (arguments) ...) {}
+
+        variant_destructor_base (variant_destructor_base const &) = default;
+        variant_destructor_base (variant_destructor_base &&) = default;
+
+        ~variant_destructor_base()
+            noexcept (all_of <is_nothrow_destructed_alternative <Types,
+                variant <Types ...>>::value ...>::value)
+        { this->destruct_content(); }
+    };
+
+} // namespace variant_detail
+
 /**
 A variant type: it contains exactly one of the types from Types.
 It is known only at run-time which type it contains.
@@ -151,194 +1265,31 @@ variant.
 The following operators are not overloaded:
     operator&& and operator|| (short-circuiting would not be possible)
     operator, (makes no sense in the usual setting)
+
+Internally, operations that depend on the contained type, like destruction,
+copying, and operator(), dispatch on which().
+How they do this is determined by variant_dispatch_policy <variant <...>>.
 */
-template <typename ... Types> class variant {
+template <typename ... Types> class variant
+: public variant_detail::variant_destructor_base <
+    variant_detail::all_of <
+        variant_detail::is_trivially_destructed_alternative <Types,
+            variant <Types ...>>::value ...
+    >::value, Types ...>
+{
+    typedef variant_detail::variant_destructor_base <
+        variant_detail::all_of <
+            variant_detail::is_trivially_destructed_alternative <Types,
+                variant <Types ...>>::value ...>::value, Types ...> base_type;
+
 public:
-    typedef meta::vector <Types...> types;
-    typedef typename meta::as_vector <typename meta::enumerate <types>::type
-        >::type numbered_types;
+    typedef typename base_type::types types;
+    typedef typename base_type::numbered_types numbered_types;
 
 private:
-    template <typename Type> struct sanity_check {
-        typedef int dummy;
-
-        static_assert (!is_variant <Type>::value,
-            "variant<...> cannot contain a variant<..>.");
-
-        typedef typename meta::as_vector <meta::filter <
-                std::is_same <Type, boost::mpl::_>, types>>::type
-            duplicate_types;
-
-        static_assert (meta::size <duplicate_types>::value == 1,
-            "Type can only appear in the list of variant types once");
-    };
-
-    typedef meta::vector <typename sanity_check <Types>::dummy ...>
-        trigger_sanity_check;
-
-    std::size_t which_;
-
-    // Set up storage size and alignment
-    typedef typename meta::filter <
-            mpl::not_ <std::is_same <boost::mpl::_, void> >, types
-        > types_without_void;
-
-    typedef typename meta::as_vector <meta::transform <
-            ::utility::storage::store <boost::mpl::_>, types_without_void
-        >>::type stored_types;
-
-    typedef typename utility::aligned_union <stored_types>::type
-        storage_type;
-    storage_type storage;
+    typedef typename base_type::dispatch_policy_type dispatch_policy_type;
 
     template <typename Actual> friend struct variant_detail::get;
-    void * memory() { return &storage; }
-    void const * memory() const { return &storage; }
-
-    /**
-    Find the best match for Actual.
-    This produces a list of equally-likely candidates, in "candidates".
-    If this list is empty, a static assertion is triggered.
-    Use assert_unambiguous::dummy (a type that evaluates to int) as soon as
-    possible in the call stack to trigger that static assertion and one for
-    an ambiguous conversion.
-    */
-    template <typename Actual> struct conversion_for {
-
-        // Match the second type of meta::vector <Index, Type>
-        typedef mpl::second <mpl::_> _;
-
-        typedef typename variant_detail::find_candidates <
-            Actual, numbered_types,
-            // Go through matches one by one:
-            // Exact match
-            std::is_same <_, Actual>,
-            // Remove reference from Actual
-            std::is_same <_, typename std::remove_reference <Actual>::type >,
-            // Remove reference from Actual and remove const-qualification
-            std::is_same <std::remove_const <_>, typename std::remove_const <
-                typename std::remove_reference <Actual>::type>::type >,
-            // Convertible in general?
-            boost::mpl::and_ <std::is_convertible <Actual, _>,
-                boost::mpl::not_ <std::is_reference <_> > >
-        >::type numbered_candidates;
-
-        static const bool conversion_possible =
-            (meta::size <numbered_candidates>::value >= 1);
-
-        static_assert (conversion_possible,
-            "No conversion to variant <...> found. "
-            "For details, see the type: "
-            "rime::variant <...>::conversion_for <(type passed in)>.");
-
-        /**
-        This class encapsulates an assertion similar to the one above.
-        It is in a class so that the error message shows the candidate targets
-        that are being considered.
-
-        The assertion is phrased as <= 1 so that either the one above is
-        triggered, or the one above, so as to not clutter the compiler output
-        even more.
-        */
-        template <typename Candidates> struct assert_unambiguous_conversion {
-            typedef int dummy;
-            static_assert (meta::size <Candidates>::value <= 1,
-                "The conversion to the variant type is ambiguous: "
-                "multiple types are equally good. "
-                "For details, see the type: "
-                "rime::variant <...>::conversion_for <(type passed in)>"
-                "::assert_unambiguous_conversion <"
-                "meta::vector <(possible candidates)>>."
-                );
-        };
-
-        // For a clearer error message
-        typedef typename meta::as_vector <meta::transform <
-            mpl::second <mpl::_>, numbered_candidates>>::type candidates;
-
-        typedef assert_unambiguous_conversion <candidates> assert_unambiguous;
-    };
-
-    /**
-    Find the best match for the contained types in OtherVariant.
-    This can only be used to trigger early static assertions when converting
-    from variant types.
-    Use dummy (a type that evaluates to int) as soon as possible in the call
-    stack to trigger a compiler error.
-    */
-    template <typename OtherVariant,
-        class ContainedTypes = typename variant_types <OtherVariant>::type>
-    struct conversion_for_contained_types;
-
-    template <typename OtherVariant, typename ... ContainedTypes>
-        struct conversion_for_contained_types <
-            OtherVariant, meta::vector <ContainedTypes...>>
-    {
-        template <typename ... Arguments> struct int_ { typedef int type; };
-
-        typedef typename int_ <typename conversion_for <typename
-            ::utility::storage::get <
-            ContainedTypes, OtherVariant &&>::type>::
-            assert_unambiguous::dummy...>::type dummy;
-    };
-
-    /**
-    Construct from another type.
-    The other type should not be a variant, but instead a type extracted from
-    it.
-    This function compiles happily even if the conversion is ambiguous.
-    This keeps the compiler errors from being cluttered.
-    However, by using conversion_for, a static assertion should be triggered.
-
-    There is another version of this below for the case when no conversion is
-    found at all.
-    This is just, again, because of the jumbled compiler errors this would
-    generate.
-    */
-    template <typename Actual, typename NumberedCandidates
-        = typename conversion_for <Actual>::numbered_candidates>
-    void construct (Actual && actual, typename
-        boost::disable_if <meta::empty <NumberedCandidates>>::type * = 0)
-    {
-        typedef typename meta::first <NumberedCandidates>::type
-            interpretation;
-
-        static const std::size_t index =
-            mpl::first <interpretation>::type::value;
-        typedef typename mpl::second <interpretation>::type type;
-        typedef typename ::utility::storage::store <type>::type store_type;
-
-        static_assert (sizeof (store_type) <= sizeof (storage_type),
-            "Sanity check: there should be enough space to contain type");
-        static_assert (alignof (store_type) <= alignof (storage_type),
-            "Sanity check: the alignment should be great enough for type");
-
-        // Set up index
-        this->which_ = index;
-        // Copy-construct or move-construct as type "store_type"
-        new (memory()) store_type (std::forward <Actual> (actual));
-    }
-
-    /**
-    Construct from a type when this is impossible.
-    Since this is impossible, this is not implemented.
-    Therefore, it does not produce compiler errors, which reduces clutter.
-    */
-    template <typename Actual, typename NumberedCandidates
-        = typename conversion_for <Actual>::numbered_candidates>
-    void construct (Actual && actual, typename
-        boost::enable_if <meta::empty <NumberedCandidates>>::type * = 0);
-
-    void construct_void() {
-        static_assert (meta::contains <void, types>::value,
-            "Attempt to void-construct a variant "
-            "that cannot contain a void value. "
-            "This is caused by calling the nullary constructor "
-            "or by copy-constructing from a variant that can contain void.");
-
-        this->which_ = index_of <void>::value;
-        // Nothing needs to be stored.
-    }
 
 public:
     /* Construction */
@@ -352,83 +1303,78 @@ public:
     */
     template <typename Actual>
         variant (Actual && actual,
-            // Make sure that the copy constructor is picked up.
-            typename boost::disable_if <is_variant <Actual> >::type * = 0,
+            // Make sure that the copy constructor and the in-place
+            // constructors are picked up.
+            typename boost::disable_if <boost::mpl::or_ <is_variant <Actual>,
+                variant_detail::is_in_place_tag <
+                    typename std::decay <Actual>::type>> >::type * = 0,
             // Trigger assertion here already.
             // This keeps the backtrace in the compiler error shortish.
-            int = typename conversion_for <Actual>::assert_unambiguous::dummy())
-    { construct (std::forward <Actual> (actual)); }
+            int = typename base_type::template conversion_for <Actual>
+                ::assert_unambiguous::dummy())
+    : base_type (variant_detail::construct_tag <variant_detail::from_value>(),
+        std::forward <Actual> (actual)) {}
 
-    explicit variant() { construct_void(); }
+    explicit variant()
+    : base_type (variant_detail::construct_tag <variant_detail::from_void>())
+    {}
 
-private:
     /**
-    Perform copy construction.
-    This is called when it turns out, at run time, that that_variant contains an
-    object of type Actual.
+    Construct an object of type \a Type in place, from \a arguments.
+    Unlike the converting constructor, this does not need a temporary of type
+    \a Type.
     */
-    template <typename Actual, typename Dummy = void>
-        struct construct_from_variant_containing
-    {
-        template <class ThatVariant> void operator() (
-            variant & this_variant, ThatVariant && that_variant/*,
-            // Trigger assertion here already.
-            // This keeps the backtrace in the compiler error shortish.
-            int = conversion_for <Actual>::assert_unambiguous::dummy()*/)
-            const
-        {
-            this_variant.construct (get_unsafe <Actual> (
-                std::forward <ThatVariant> (that_variant)));
-        }
-    };
-    template <typename Dummy>
-        struct construct_from_variant_containing <void, Dummy>
-    {
-        template <class ThatVariant> void operator() (
-            variant & this_variant, ThatVariant && that_variant) const
-        {
-            // Assert that that_variant contains void.
-            get_unsafe <void> (std::forward <ThatVariant> (that_variant));
-            this_variant.construct_void();
-        }
-    };
+    template <class Type, class ... Arguments>
+        explicit variant (in_place_type <Type>, Arguments && ... arguments)
+    : base_type (variant_detail::construct_tag <
+            variant_detail::from_in_place <Type>>(),
+        std::forward <Arguments> (arguments) ...) {}
 
-    template <typename ThatVariant>
-        void construct_from_other_variant (ThatVariant && that,
-            // Trigger assertion here.
-            int = typename conversion_for_contained_types <ThatVariant>
-                ::dummy())
-    {
-        /*
-        This constructs an object of type
-            construct_from_variant_containing <Actual>,
-        and calls it with (*this, that).
-        */
-        typedef meta::transform <
-                construct_from_variant_containing <boost::mpl::_>,
-                typename variant_types <ThatVariant>::type
-            > specialisations;
-        ::rime::detail::switch_ <void, specialisations> s;
-        s (that.which(), *this, std::forward <ThatVariant> (that));
-    }
+    /**
+    Construct an object of the type with index \a Index in place, from
+    \a arguments.
+    */
+    template <std::size_t Index, class ... Arguments>
+        explicit variant (in_place_index <Index>, Arguments && ... arguments)
+    : base_type (variant_detail::construct_tag <variant_detail::from_in_place <
+            typename std::tuple_element <Index, std::tuple <Types ...>>::type>
+        >(), std::forward <Arguments> (arguments) ...) {}
+
+    /**
+    Construct an object of trivially copyable type \a Type by calling
+    \a fill with the address of its storage, which \a fill must fill with
+    the bytes of an object.
+    This is used by rime::deserialize to read an object directly into the
+    variant.
+    */
+    template <class Type, class Fill>
+        variant (variant_detail::construct_tag <
+                variant_detail::from_bytes <Type>> tag,
+            Fill && fill)
+    : base_type (tag, std::forward <Fill> (fill)) {}
 
-public:
     // Explicitly enumerate the copy and move constructors to minimise
     // ambiguity.
 
-    /// Copy constructor
-    variant (variant const & that)
-    { construct_from_other_variant (that); }
+    /**
+    Copy constructor.
+    This is trivial if all contained types are trivially copyable.
+    */
+    variant (variant const &) = default;
 
     /// Generalised copy constructor
     template <typename ThatVariant>
         variant (ThatVariant const & that,
             typename boost::enable_if <is_variant <ThatVariant> >::type * = 0)
-    { construct_from_other_variant (that); }
+    : base_type (variant_detail::construct_tag <variant_detail::from_variant>(),
+        that) {}
 
-    /// Move constructor
-    variant (variant && that)
-    { construct_from_other_variant (std::forward <variant> (that)); }
+    /**
+    Move constructor.
+    This is trivial if all contained types are trivially copyable, and noexcept
+    if moving none of the contained types can throw.
+    */
+    variant (variant &&) = default;
 
     /// Generalised move constructor
     template <typename ThatVariant>
@@ -437,40 +1383,15 @@ public:
                 is_variant <ThatVariant>,
                 boost::mpl::not_ <std::is_reference <ThatVariant> >
             > >::type * = 0)
-    { construct_from_other_variant (std::forward <ThatVariant> (that)); }
+    : base_type (variant_detail::construct_tag <variant_detail::from_variant>(),
+        std::forward <ThatVariant> (that)) {}
 
-    /* Destruction */
-private:
     /**
-    Destruct the object that "this" contains.
-    This is called when it turns out, at run time, that "this" contains an
-    object of type Actual.
+    Destructor.
+    This is trivial if all contained types are trivially destructible, and
+    noexcept unless the destructor of one of them is not.
     */
-    template <typename Actual, typename Dummy = void> struct destruct {
-        void operator() (void * memory) const
-        {
-            typedef typename ::utility::storage::store <Actual>::type
-                stored_type;
-            static_cast <stored_type *> (memory)->~stored_type();
-        }
-    };
-    // void is not stored and does not need to be destructed.
-    template <typename Dummy> struct destruct <void, Dummy>
-    { void operator() (void *) const {}; };
-
-    void destruct_content() {
-        /*
-        This constructs an object of type destruct <Actual>,
-        and calls it with this->memory().
-        */
-        typedef meta::transform <destruct <boost::mpl::_>, types>
-            specialisations;
-        ::rime::detail::switch_ <void, specialisations> s;
-        s (this->which(), this->memory());
-    }
-
-public:
-    ~variant() { destruct_content(); }
+    ~variant() = default;
 
 private:
     /**
@@ -500,37 +1421,43 @@ public:
         typename boost::enable_if <is_variant <ThatVariant>>::type
             replace (ThatVariant && that)
     {
-        destruct_content();
+        this->destruct_content();
         // We are now at a dangerous time where the memory is uninitialised.
         // Set a guard that calls construct_void if an exception is thrown.
         construct_void_guard guard (*this);
-        construct_from_other_variant (std::forward <ThatVariant> (that));
+        this->construct_from_other_variant (std::forward <ThatVariant> (that));
         // If we get here, no exception has been thrown, and we can dismiss the
         // guard.
         guard.dismiss();
     }
 
+    /**
+    Replace the contents of this with an object of type \a Type, constructed
+    in place from \a arguments.
+    Like replace(), this requires that "void" is a possible content type,
+    which will be used if an exception is thrown during construction.
+    */
+    template <class Type, class ... Arguments>
+        typename boost::enable_if <meta::contains <Type, types>>::type
+        emplace (Arguments && ... arguments)
+    {
+        this->destruct_content();
+        construct_void_guard guard (*this);
+        this->template construct_in_place <Type> (
+            std::forward <Arguments> (arguments) ...);
+        guard.dismiss();
+    }
+
     /**
     \return The index, in the template parameter list, of the contained type.
     */
-    std::size_t which() const { return which_; }
+    std::size_t which() const { return base_type::which(); }
 
     /**
     Find the index of type Actual amongst the possible types of this variant.
     */
-    template <typename Actual> struct index_of {
-        typedef meta::filter <std::is_same <mpl::second <mpl::_>, Actual>,
-            numbered_types> candidates;
-
-        typedef typename meta::first <candidates>::type index_and_type;
-
-        static_assert (std::is_same <
-            typename mpl::second <index_and_type>::type, Actual>::value,
-            "Sanity check: should have found Actual");
-
-        static const std::size_t value
-            = mpl::first <index_and_type>::type::value;
-    };
+    template <typename Actual> struct index_of
+    : base_type::template index_of <Actual> {};
 
     /**
     \return true iff type Actual is contained.
@@ -549,7 +1476,7 @@ private:
     {
         assert (this->contains <Actual>());
         return static_cast <typename utility::storage::store <Actual>::type *> (
-            this->memory());
+            this->template object_memory <Actual>());
     }
     template <typename Actual> typename
         utility::storage::store <Actual>::type const * memory_for() const
@@ -557,7 +1484,7 @@ private:
         assert (this->contains <Actual>());
         return static_cast <
             typename utility::storage::store <Actual>::type const *> (
-            this->memory());
+            this->template object_memory <Actual>());
     }
 
     /* Assignment */
@@ -586,7 +1513,8 @@ public:
     */
     template <class That> variant & operator = (That && that) {
         // Forward to assign.
-        visit (assign()) (*this, std::forward <That> (that));
+        visit <dispatch_policy_type> (assign()) (
+            *this, std::forward <That> (that));
         return *this;
     }
 
@@ -600,7 +1528,8 @@ private: \
     \
 public: \
     template <class That> variant & operator operation (That && that) { \
-        visit (name()) (*this, std::forward <That> (that)); \
+        visit <dispatch_policy_type> (name()) ( \
+            *this, std::forward <That> (that)); \
         return *this; \
     }
 
@@ -673,7 +1602,10 @@ private:
             variant_detail::convert_result <result_type, boost::mpl::_>,
             specialisations> coerced_specialisations;
 
-        static rime::detail::switch_ <result_type, coerced_specialisations> s;
+        RIME_DETAIL_COUNT_DISPATCH (compute_specialisations,
+            sizeof ... (Types), variant.which());
+        static rime::detail::switch_ <
+            result_type, coerced_specialisations, dispatch_policy_type> s;
         return s (variant.which(),
             std::forward <Variant> (variant),
             std::forward <Arguments> (arguments) ...);
@@ -719,12 +1651,12 @@ private:
 
     // This class is necessary to wrap decltype() in GCC 4.6.
     template <typename Variant, typename Argument> struct subscript_with {
-        typedef decltype (visit (subscript()) (
+        typedef decltype (visit <dispatch_policy_type> (subscript()) (
             std::declval <Variant &>(), std::declval <Argument &&>()))
             result_type;
 
         result_type operator() (Variant & variant, Argument && argument) const {
-            return visit (subscript()) (
+            return visit <dispatch_policy_type> (subscript()) (
                 variant, std::forward <Argument> (argument));
         }
     };
@@ -759,13 +1691,43 @@ namespace variant_detail {
     */
     template <typename Actual> struct get {
         template <class Variant>
-            typename ::utility::storage::get <Actual, Variant &&>::type
+            typename boost::disable_if <boost::mpl::or_ <
+                    is_variant_ref <Variant>,
+                    is_tag_in_pointer_variant <Variant>>,
+                typename ::utility::storage::get <Actual, Variant &&>::type
+            >::type
             operator() (Variant && variant) const
         {
             ::utility::storage::get <Actual, Variant &&> extract;
             return extract (*variant.template memory_for <Actual>());
         }
 
+        // Variant that stores the index in the pointer: Actual is a
+        // reference to the object whose address it holds.
+        template <class Variant>
+            typename boost::enable_if <is_tag_in_pointer_variant <Variant>,
+                typename ::utility::storage::get <Actual, Variant &&>::type
+            >::type
+            operator() (Variant && variant) const
+        {
+            assert (variant.template contains <Actual>());
+            typedef typename std::remove_reference <Actual>::type object_type;
+            return *static_cast <object_type *> (variant.pointer());
+        }
+
+        // variant_ref: Actual is a reference to the object it refers to.
+        template <class Reference>
+            typename boost::enable_if <is_variant_ref <Reference>,
+                typename ::utility::storage::get <Actual, Reference &&>::type
+            >::type
+            operator() (Reference && reference) const
+        {
+            assert (reference.template contains <Actual>());
+            typedef typename std::remove_reference <Actual>::type object_type;
+            return *static_cast <object_type *> (
+                const_cast <void *> (reference.object_));
+        }
+
         template <class Variant>
             typename ::utility::storage::get_pointer <Actual, Variant>::type
             operator() (Variant * variant) const
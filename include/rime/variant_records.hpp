@@ -0,0 +1,537 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Define a binary format for sequences of variant records, which can be read
+in place, for example from a memory-mapped file.
+
+The format consists of a header, variant_records_header, followed, at the
+first offset aligned for all types, by the records.
+The records have the same layout as in packed_variant_sequence: each is the
+index of its type, in the smallest unsigned integer that fits, followed by
+the bytes of the object at its own alignment.
+The header records the tag width, the alignment, and a fingerprint of the
+list of types, so that a reader with a different list of types rejects the
+data.
+Numbers are stored in the byte order of the machine that writes them; a
+reader on a machine with a different byte order rejects the data.
+
+Only trivially copyable types, and void, can be stored.
+Types other than void and the arithmetic types must have a specialisation of
+variant_record_type_id.
+*/
+
+#ifndef RIME_VARIANT_RECORDS_HPP_INCLUDED
+#define RIME_VARIANT_RECORDS_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
+#include <boost/utility/enable_if.hpp>
+
+#include "meta/vector.hpp"
+
+#include "rime/variant.hpp"
+#include "rime/variant_ref.hpp"
+#include "rime/detail/switch.hpp"
+#include "rime/detail/packed_layout.hpp"
+
+namespace rime {
+
+/**
+Exception that is thrown when data is not in the variant records format, or
+is for a different list of types.
+*/
+class variant_records_error : public std::runtime_error {
+public:
+    explicit variant_records_error (char const * message)
+    : std::runtime_error (message) {}
+};
+
+/**
+Number that identifies a type in the fingerprint of a list of types, made
+from \a Kind, which must be unique for the type, and the size and alignment
+of Type, so that data written on a platform where the type has a different
+layout is rejected.
+Kinds below 256 are reserved for the fundamental types.
+*/
+template <class Type, std::uint32_t Kind> struct variant_record_type_id_base {
+    static const std::uint64_t value = (std::uint64_t (Kind) << 32)
+        | (std::uint64_t (sizeof (Type)) << 16) | alignof (Type);
+};
+
+/**
+Number that identifies Type in the fingerprint of a list of types.
+This is defined for void and for the arithmetic types.
+For any other type, there is no way of telling from the type alone whether
+data written with it can be read back, so this must be specialised, for
+example as
+\code
+namespace rime {
+    template <> struct variant_record_type_id <my_point>
+    : variant_record_type_id_base <my_point, 1000> {};
+}
+\endcode
+Give the specialisation a new kind when the meaning or the layout of the type
+changes, so that old data is rejected.
+*/
+template <class Type> struct variant_record_type_id {
+    static_assert (std::is_void <Type>::value && !std::is_void <Type>::value,
+        "Specialise rime::variant_record_type_id for this type to store it "
+        "in variant records.");
+    static const std::uint64_t value = 0;
+};
+
+template <> struct variant_record_type_id <void> {
+    static const std::uint64_t value = 0;
+};
+
+#define RIME_DETAIL_VARIANT_RECORD_TYPE_ID(type, kind) \
+    template <> struct variant_record_type_id <type> \
+    : variant_record_type_id_base <type, kind> {};
+
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (bool, 1)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (char, 2)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (signed char, 3)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (unsigned char, 4)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (wchar_t, 5)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (char16_t, 6)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (char32_t, 7)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (short, 8)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (unsigned short, 9)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (int, 10)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (unsigned, 11)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (long, 12)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (unsigned long, 13)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (long long, 14)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (unsigned long long, 15)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (float, 16)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (double, 17)
+RIME_DETAIL_VARIANT_RECORD_TYPE_ID (long double, 18)
+
+#undef RIME_DETAIL_VARIANT_RECORD_TYPE_ID
+
+/**
+Header at the start of data in the variant records format.
+*/
+struct variant_records_header {
+    /// "rimevrec" once the data is complete; zeros while it is written.
+    char magic [8];
+    std::uint32_t version;
+    /// 0x01020304 in the byte order of the writer.
+    std::uint32_t byte_order;
+    /// The size in bytes of the index of the type of each record.
+    std::uint32_t tag_width;
+    /// The alignment of the start of the records.
+    std::uint32_t alignment;
+    std::uint32_t type_num;
+    std::uint32_t reserved;
+    std::uint64_t fingerprint;
+    std::uint64_t record_num;
+    /// The size in bytes of the records, starting from data_offset.
+    std::uint64_t data_size;
+};
+
+/**
+Description of the variant records format for Types.
+*/
+template <class ... Types> struct variant_records_format {
+    typedef variant_detail::packed_layout <Types ...> layout;
+
+    template <typename Type> struct sanity_check {
+        typedef int dummy;
+        static_assert (!std::is_reference <Type>::value,
+            "Variant records cannot contain references.");
+        static_assert (variant_detail::packed_payload <Type>
+            ::trivially_copyable,
+            "Variant records can only contain trivially copyable types.");
+    };
+
+    typedef meta::vector <typename sanity_check <Types>::dummy ...>
+        trigger_sanity_check;
+
+    static const std::uint32_t version = 1;
+    static const std::uint32_t byte_order = 0x01020304;
+
+    /**
+    \return The offset of the records from the start of the header.
+    */
+    static std::size_t data_offset() {
+        return variant_detail::round_up (sizeof (variant_records_header),
+            variant_detail::max_of <layout::alignment,
+                alignof (variant_records_header)>::value);
+    }
+
+    /**
+    \return A hash (64-bit FNV-1a) of the tag width, the alignment, and the
+    identifiers of the types in order.
+    */
+    static std::uint64_t fingerprint() {
+        std::uint64_t const values [] = {
+            sizeof (typename layout::which_type), layout::alignment,
+            sizeof ... (Types), variant_record_type_id <Types>::value ... };
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for (std::uint64_t value : values) {
+            for (int byte = 0; byte != 8; ++ byte) {
+                hash ^= (value >> (8 * byte)) & 0xff;
+                hash *= 0x100000001b3ull;
+            }
+        }
+        return hash;
+    }
+
+    static variant_records_header make_header (
+        std::uint64_t record_num, std::uint64_t data_size)
+    {
+        variant_records_header header;
+        std::memcpy (header.magic, "rimevrec", 8);
+        header.version = version;
+        header.byte_order = byte_order;
+        header.tag_width = sizeof (typename layout::which_type);
+        header.alignment = layout::alignment;
+        header.type_num = sizeof ... (Types);
+        header.reserved = 0;
+        header.fingerprint = fingerprint();
+        header.record_num = record_num;
+        header.data_size = data_size;
+        return header;
+    }
+
+    /**
+    Check that the \a size bytes at \a data start with a header that
+    matches Types, and contain all the records that it announces.
+    \throw variant_records_error if this is not the case.
+    */
+    static variant_records_header const & check_header (
+        void const * data, std::size_t size)
+    {
+        // The data is padded to data_offset() even if there are no records.
+        // Checking this first also makes size - data_offset() below safe.
+        if (size < data_offset())
+            throw variant_records_error ("Variant records: data too short");
+        if (reinterpret_cast <std::uintptr_t> (data) % layout::alignment != 0
+            || reinterpret_cast <std::uintptr_t> (data)
+                % alignof (variant_records_header) != 0)
+            throw variant_records_error ("Variant records: misaligned data");
+        variant_records_header const & header =
+            *static_cast <variant_records_header const *> (data);
+        if (std::memcmp (header.magic, "rimevrec", 8) != 0)
+            throw variant_records_error (
+                "Variant records: not in the format, or incomplete");
+        if (header.byte_order != byte_order)
+            throw variant_records_error ("Variant records: wrong byte order");
+        if (header.version != version)
+            throw variant_records_error ("Variant records: unknown version");
+        if (header.tag_width != sizeof (typename layout::which_type)
+            || header.alignment != layout::alignment
+            || header.type_num != sizeof ... (Types)
+            || header.fingerprint != fingerprint())
+            throw variant_records_error (
+                "Variant records: written for different types");
+        if (header.data_size > size - data_offset())
+            throw variant_records_error ("Variant records: data truncated");
+        return header;
+    }
+};
+
+/**
+Write variant records of Types to a std::ostream, which must be seekable.
+The header is written first with its magic number cleared, and completed by
+finish(); a reader rejects the data until then.
+*/
+template <class ... Types> class variant_records_writer {
+    typedef variant_records_format <Types ...> format;
+    typedef typename format::layout layout;
+    typedef typename layout::which_type which_type;
+
+    std::ostream & stream_;
+    std::ostream::pos_type start_;
+    std::uint64_t record_num_;
+    std::size_t offset_;
+
+    /**
+    \throw variant_records_error If the last operation on the stream failed.
+    */
+    void check_stream() const {
+        if (!stream_)
+            throw variant_records_error ("Variant records: write failed");
+    }
+
+    void pad_to (std::size_t offset) {
+        static char const zeros [64] = {};
+        while (offset_ != offset) {
+            std::size_t count = offset - offset_;
+            if (count > sizeof (zeros))
+                count = sizeof (zeros);
+            stream_.write (zeros, count);
+            check_stream();
+            offset_ += count;
+        }
+    }
+
+    void write_record (std::size_t which, void const * object) {
+        which_type tag = which_type (which);
+        stream_.write (reinterpret_cast <char const *> (&tag), sizeof (tag));
+        check_stream();
+        offset_ += sizeof (tag);
+        pad_to (layout::payload_offset (which, offset_ - sizeof (tag)));
+        std::size_t size = layout::payload_sizes [which];
+        stream_.write (static_cast <char const *> (object), size);
+        check_stream();
+        offset_ += size;
+        pad_to (variant_detail::round_up (offset_, alignof (which_type)));
+        ++ record_num_;
+    }
+
+    /**
+    Write the object that a variant contains.
+    */
+    struct write_contained {
+        variant_records_writer & writer;
+        explicit write_contained (variant_records_writer & writer)
+        : writer (writer) {}
+
+        template <class Object> void operator() (Object const & object) const
+        { writer.append (object); }
+
+        void operator() () const { writer.append_void(); }
+    };
+
+public:
+    /**
+    Start writing at the current position of \a stream.
+    \throw variant_records_error If writing to the stream fails, here or in
+        any of the other member functions.
+    */
+    explicit variant_records_writer (std::ostream & stream)
+    : stream_ (stream), start_ (stream.tellp()), record_num_ (0), offset_ (0)
+    {
+        check_stream();
+        variant_records_header header = format::make_header (0, 0);
+        std::memset (header.magic, 0, sizeof (header.magic));
+        stream_.write (reinterpret_cast <char const *> (&header),
+            sizeof (header));
+        check_stream();
+        offset_ = sizeof (header);
+        pad_to (format::data_offset());
+        offset_ = 0;
+    }
+
+    std::uint64_t size() const { return record_num_; }
+
+    /**
+    Append a record that contains \a object, whose type must be one of
+    Types, apart from const-qualification.
+    */
+    template <class Object>
+        typename boost::disable_if <is_variant <Object>>::type
+        append (Object const & object)
+    {
+        typedef typename std::remove_cv <Object>::type type;
+        static_assert (meta::contains <type, meta::vector <Types ...>>::value,
+            "The type of the object must be one of the types of the records.");
+        write_record (variant_detail::variant_base <Types ...>::template
+            index_of <type>::value, &object);
+    }
+
+    /// Append a record of type void.
+    void append_void() {
+        write_record (variant_detail::variant_base <Types ...>::template
+            index_of <void>::value, nullptr);
+    }
+
+    /**
+    Append a record that contains the object that \a v contains.
+    The variant can be a variant_ref, or have references as types.
+    */
+    template <class Variant>
+        typename boost::enable_if <is_variant <Variant>>::type
+        append (Variant const & v)
+    { rime::visit (write_contained (*this)) (v); }
+
+    /**
+    Complete the header.
+    Before this is called, the data is not readable.
+    */
+    void finish() {
+        variant_records_header header = format::make_header (
+            record_num_, offset_);
+        std::ostream::pos_type end = stream_.tellp();
+        check_stream();
+        stream_.seekp (start_);
+        check_stream();
+        stream_.write (reinterpret_cast <char const *> (&header),
+            sizeof (header));
+        check_stream();
+        stream_.seekp (end);
+        check_stream();
+        stream_.flush();
+        check_stream();
+    }
+};
+
+/**
+View of variant records of Types in memory, for example in a memory-mapped
+file.
+This does not copy the records: iterating yields variant_ref objects that
+refer to the bytes in place, which rime::visit and rime::get accept.
+The memory must stay valid while the view is used.
+
+Only the header is checked on construction, so that a view of a large file
+can be created without reading all of it.
+Call check_records() to check the indices of all records, if the data may be
+corrupt.
+*/
+template <class ... Types> class variant_records_view {
+    typedef variant_records_format <Types ...> format;
+    typedef typename format::layout layout;
+
+    char const * records_;
+    std::uint64_t record_num_;
+    std::size_t data_size_;
+
+    /**
+    Call a function with the object at \a payload, or without arguments if
+    it is void.
+    */
+    template <class Type, class Dummy = void> struct call_record {
+        template <class Function>
+            void operator() (char const * payload, Function & function) const
+        { function (*reinterpret_cast <Type const *> (payload)); }
+    };
+    template <class Dummy> struct call_record <void, Dummy> {
+        template <class Function>
+            void operator() (char const *, Function & function) const
+        { function(); }
+    };
+
+public:
+    typedef variant_ref <typename variant_detail::packed_const_element <
+        Types>::type ...> reference;
+
+    /**
+    Forward iterator over the records.
+    Dereferencing it yields a variant_ref, by value.
+    */
+    class const_iterator
+    : public std::iterator <std::forward_iterator_tag, reference,
+        std::ptrdiff_t, void, reference>
+    {
+        friend class variant_records_view;
+
+        char const * records_;
+        std::size_t tag_;
+
+        const_iterator (char const * records, std::size_t tag)
+        : records_ (records), tag_ (tag) {}
+
+    public:
+        const_iterator() : records_ (nullptr), tag_ (0) {}
+
+        reference operator*() const {
+            std::size_t which = layout::which (records_ + tag_);
+            return variant_detail::variant_ref_access::make <reference> (
+                records_ + layout::payload_offset (which, tag_), which);
+        }
+
+        const_iterator & operator++() {
+            tag_ = layout::record_end (layout::which (records_ + tag_), tag_);
+            return *this;
+        }
+
+        const_iterator operator++ (int) {
+            const_iterator result = *this;
+            ++ *this;
+            return result;
+        }
+
+        bool operator== (const_iterator const & that) const
+        { return records_ == that.records_ && tag_ == that.tag_; }
+        bool operator!= (const_iterator const & that) const
+        { return !(*this == that); }
+    };
+
+    typedef const_iterator iterator;
+
+    /**
+    \param data The address of the header, which must be aligned.
+    \param size The number of bytes available at \a data.
+    \throw variant_records_error
+        If the data is not complete variant records of Types.
+    */
+    variant_records_view (void const * data, std::size_t size) {
+        variant_records_header const & header =
+            format::check_header (data, size);
+        records_ = static_cast <char const *> (data) + format::data_offset();
+        record_num_ = header.record_num;
+        data_size_ = std::size_t (header.data_size);
+    }
+
+    std::uint64_t size() const { return record_num_; }
+    bool empty() const { return record_num_ == 0; }
+
+    const_iterator begin() const { return const_iterator (records_, 0); }
+    const_iterator end() const
+    { return const_iterator (records_, data_size_); }
+
+    /**
+    Call \a function with every record, in order, as a const reference to
+    the object in place, or without arguments if the record is void.
+    */
+    template <class Function> void visit_each (Function && function) const {
+        ::rime::detail::switch_ <void, meta::vector <call_record <Types> ...>,
+            typename variant_dispatch_policy <variant <Types ...>>::type> s;
+        std::size_t tag = 0;
+        while (tag != data_size_) {
+            std::size_t which = layout::which (records_ + tag);
+            s (which, records_ + layout::payload_offset (which, tag),
+                function);
+            tag = layout::record_end (which, tag);
+        }
+    }
+
+    /**
+    Check that the index of every record is valid, and that the records
+    fill the data exactly.
+    \throw variant_records_error If this is not the case.
+    */
+    void check_records() const {
+        std::size_t tag = 0;
+        std::uint64_t count = 0;
+        while (tag < data_size_) {
+            if (data_size_ - tag < sizeof (typename layout::which_type))
+                throw variant_records_error ("Variant records: corrupt");
+            std::size_t which = layout::which (records_ + tag);
+            if (which >= sizeof ... (Types))
+                throw variant_records_error ("Variant records: corrupt");
+            tag = layout::record_end (which, tag);
+            ++ count;
+        }
+        if (tag != data_size_ || count != record_num_)
+            throw variant_records_error ("Variant records: corrupt");
+    }
+};
+
+} // namespace rime
+
+#endif // RIME_VARIANT_RECORDS_HPP_INCLUDED
@@ -0,0 +1,233 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Define a non-owning reference to an object that has one of a number of types.
+*/
+
+#ifndef RIME_VARIANT_REF_HPP_INCLUDED
+#define RIME_VARIANT_REF_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+#include <boost/utility/enable_if.hpp>
+#include <boost/integer.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/placeholders.hpp>
+
+#include "meta/vector.hpp"
+#include "meta/enumerate.hpp"
+#include "meta/contains.hpp"
+#include "meta/filter.hpp"
+
+#include "rime/variant.hpp"
+
+namespace rime {
+
+namespace variant_detail {
+
+    /**
+    Compile-time constant that is true iff a variant_ref that refers to
+    Target can refer to an object of type Source.
+    Only const-qualification can be added.
+    */
+    template <class Target, class Source> struct can_refer_to
+    : boost::mpl::bool_ <!std::is_reference <Source>::value
+        && (std::is_same <Target, Source>::value
+            || std::is_same <Target, Source const>::value
+            || (std::is_void <Target>::value && std::is_void <Source>::value))>
+    {};
+
+    template <class Targets, class Sources, bool SameSize>
+        struct can_refer_to_all_impl
+    : boost::mpl::false_ {};
+
+    template <class ... Targets, class ... Sources>
+        struct can_refer_to_all_impl <meta::vector <Targets ...>,
+            meta::vector <Sources ...>, true>
+    : all_of <can_refer_to <Targets, Sources>::value ...> {};
+
+    /**
+    Compile-time constant that is true iff a variant_ref over Targets can
+    refer to the contents of a variant over Sources.
+    The types must be the same, in the same order, except that
+    const-qualification can be added.
+    */
+    template <class Targets, class Sources> struct can_refer_to_all
+    : can_refer_to_all_impl <Targets, Sources,
+        meta::size <Targets>::value == meta::size <Sources>::value> {};
+
+    /**
+    Construct variant_ref objects from the address of an object and the
+    index of its type, for containers that store the index themselves.
+    */
+    struct variant_ref_access {
+        template <class Reference>
+            static Reference make (void const * object, std::size_t which)
+        { return Reference (typename Reference::raw(), object, which); }
+    };
+
+} // namespace variant_detail
+
+/**
+Non-owning reference to an object of one of Types.
+This is like variant <Types & ...>, but it holds just a pointer to the object
+and the index of its type, and creating it never requires dispatching on the
+contained type.
+
+A variant_ref can be constructed from an lvalue of one of Types, or from a
+variant or variant_ref with the same types in the same order; in both cases,
+const-qualification can be added.
+A variant_ref behaves as a variant of references: rime::get <int &> (r)
+returns the object that r refers to, and it works with rime::visit and the
+operators.
+
+Types cannot contain references.
+Like a reference, the variant_ref must not outlive the object it refers to.
+*/
+template <class ... Types> class variant_ref {
+public:
+    typedef meta::vector <Types ...> types;
+    typedef typename meta::as_vector <typename meta::enumerate <types
+        >::type>::type numbered_types;
+
+private:
+    template <typename Type> struct sanity_check {
+        typedef int dummy;
+        static_assert (!std::is_reference <Type>::value,
+            "variant_ref <...> refers to objects: the types cannot be "
+            "references.");
+    };
+
+    typedef meta::vector <typename sanity_check <Types>::dummy ...>
+        trigger_sanity_check;
+
+    typedef typename boost::uint_value_t <sizeof ... (Types)>::least
+        which_type;
+
+    void const * object_;
+    which_type which_;
+
+    template <typename Actual> friend struct variant_detail::get;
+    template <class ... OtherTypes> friend class variant_ref;
+    friend struct variant_detail::variant_ref_access;
+
+    /// Tag for the constructor from an address and the index of the type.
+    struct raw {};
+
+    /**
+    Refer to the object at \a object, which has type number \a which.
+    This is used, through variant_ref_access, by containers that know the
+    type of their elements only at run time.
+    */
+    variant_ref (raw, void const * object, std::size_t which)
+    : object_ (object), which_ (which_type (which)) {}
+
+    /**
+    The numbered candidates for an lvalue of type Actual: Actual itself, or
+    else Actual const.
+    */
+    template <class Actual> struct candidates_for {
+        typedef mpl::second <mpl::_> _;
+
+        typedef typename variant_detail::find_candidates <
+            Actual, numbered_types,
+            std::is_same <_, Actual>,
+            std::is_same <_, Actual const>
+        >::type type;
+    };
+
+public:
+    /**
+    Refer to an object of one of the types.
+    */
+    template <class Actual>
+        variant_ref (Actual & object,
+            typename boost::enable_if_c <!is_variant <Actual>::value
+                && meta::size <typename candidates_for <Actual>::type>::value
+                    == 1>::type * = 0)
+    : object_ (&object),
+        which_ (which_type (mpl::first <typename meta::first <
+            typename candidates_for <Actual>::type>::type>::type::value)) {}
+
+    /**
+    Refer to the contents of a variant.
+    */
+    template <class ... OtherTypes>
+        variant_ref (variant <OtherTypes ...> & that,
+            typename boost::enable_if <variant_detail::can_refer_to_all <
+                types, meta::vector <OtherTypes ...>>>::type * = 0)
+    : object_ (static_cast <variant_detail::variant_base <OtherTypes ...> &> (
+            that).object_memory()),
+        which_ (which_type (that.which())) {}
+
+    template <class ... OtherTypes>
+        variant_ref (variant <OtherTypes ...> const & that,
+            typename boost::enable_if <variant_detail::can_refer_to_all <
+                types, meta::vector <OtherTypes const ...>>>::type * = 0)
+    : object_ (static_cast <variant_detail::variant_base <OtherTypes ...>
+            const &> (that).object_memory()),
+        which_ (which_type (that.which())) {}
+
+    /**
+    Refer to the same object as another variant_ref, possibly adding
+    const-qualification.
+    */
+    template <class ... OtherTypes>
+        variant_ref (variant_ref <OtherTypes ...> const & that,
+            typename boost::enable_if <variant_detail::can_refer_to_all <
+                types, meta::vector <OtherTypes ...>>>::type * = 0)
+    : object_ (that.object_), which_ (that.which_) {}
+
+    /**
+    \return The index, in the template parameter list, of the type of the
+    object referred to.
+    */
+    std::size_t which() const { return which_; }
+
+    /**
+    Find the index of type Actual amongst the possible types of this
+    variant_ref.
+    Actual must be a reference, as returned by get.
+    */
+    template <typename Actual> struct index_of {
+        typedef meta::filter <std::is_same <
+                std::add_lvalue_reference <mpl::second <mpl::_>>, Actual>,
+            numbered_types> candidates;
+
+        typedef typename meta::first <candidates>::type index_and_type;
+
+        static const std::size_t value
+            = mpl::first <index_and_type>::type::value;
+    };
+
+    /**
+    \return true iff the object referred to has type Actual, which must be a
+    reference, like int & or int const &.
+    */
+    template <typename Actual>
+        typename boost::enable_if <meta::contains <Actual,
+            typename variant_types <variant_ref>::type>, bool>::type
+    contains() const
+    { return which_ == index_of <Actual>::value; }
+};
+
+} // namespace rime
+
+#endif // RIME_VARIANT_REF_HPP_INCLUDED
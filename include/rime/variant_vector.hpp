@@ -0,0 +1,443 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Define a sequence of variants that stores the values of each type separately.
+*/
+
+#ifndef RIME_VARIANT_VECTOR_HPP_INCLUDED
+#define RIME_VARIANT_VECTOR_HPP_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+#include <boost/utility/enable_if.hpp>
+#include <boost/mpl/placeholders.hpp>
+
+#include "utility/storage.hpp"
+
+#include "meta/vector.hpp"
+#include "meta/transform.hpp"
+
+#include "rime/variant.hpp"
+#include "rime/variant_ref.hpp"
+#include "rime/detail/switch.hpp"
+
+namespace rime {
+
+namespace variant_detail {
+
+    /// Placeholder for the column of type void, which needs no storage.
+    struct no_column {};
+
+    /**
+    The column for elements of type Type.
+    This is normally a std::vector, but std::vector <bool> does not hold
+    bool objects that can be referred to, so bool is kept in a std::deque.
+    */
+    template <class Type> struct column_of {
+        typedef typename ::utility::storage::store <Type>::type stored_type;
+        typedef typename std::conditional <
+            std::is_same <stored_type, bool>::value,
+            std::deque <stored_type>, std::vector <stored_type>>::type type;
+    };
+
+    template <> struct column_of <void> { typedef no_column type; };
+
+    /**
+    The type that a variant_ref to an element of type Type in a
+    variant_vector refers to.
+    For a reference type, this is the object that the element refers to.
+    */
+    template <class Type> struct element_target
+    : std::remove_reference <Type> {};
+
+    /**
+    The type that a const variant_ref to an element of type Type in a
+    variant_vector refers to.
+    Reference types refer to their objects as they are.
+    */
+    template <class Type> struct element_const_target
+    : std::conditional <std::is_reference <Type>::value,
+        typename std::remove_reference <Type>::type, Type const> {};
+
+    template <> struct element_const_target <void> { typedef void type; };
+
+} // namespace variant_detail
+
+/**
+Sequence of variant <Types...> which keeps the values of each type in a
+separate, dense, column.
+This is the struct-of-arrays equivalent of std::vector <variant <Types...>>.
+Per element, it stores only the index of the type, in the smallest integer
+type that fits.
+Elements of type void take no space in any column.
+The position of an element in its column is not stored, but derived: every
+checkpoint_interval elements, the number of elements of each type so far is
+recorded, and operator[] counts the elements of the same type since the last
+checkpoint.
+This costs sizeof (std::size_t) * sizeof... (Types) / checkpoint_interval
+bytes per element.
+
+Elements are inserted with push_back, which, for values that are not variants,
+selects the type in the same way that the constructor of variant <Types...>
+does.
+operator[] returns a variant_ref to the element, which rime::visit and
+rime::get accept.
+For elements of reference type, this refers to the object that the element
+refers to.
+visit_all calls a function on all elements, one column at a time, so that the
+loop over each column can be inlined and vectorised.
+
+Types cannot contain rvalue references.
+For const access, Types cannot contain both a type and its const-qualified
+version, since the references to them would be of the same type.
+*/
+template <class ... Types> class variant_vector {
+public:
+    typedef variant <Types ...> value_type;
+
+    /// Reference to the element, as returned by operator[].
+    typedef variant_ref <typename variant_detail::element_target <Types>::type
+        ...> reference;
+    typedef variant_ref <typename variant_detail::element_const_target <
+        Types>::type ...> const_reference;
+
+    /// The number of elements between checkpoints.
+    static const std::size_t checkpoint_interval = 64;
+
+private:
+    typedef variant_detail::variant_base <Types ...> base_type;
+    typedef meta::vector <Types ...> types;
+
+    typedef typename base_type::dispatch_policy_type dispatch_policy_type;
+    typedef typename base_type::which_type which_type;
+
+    template <typename Type> struct sanity_check {
+        typedef int dummy;
+        static_assert (!std::is_rvalue_reference <Type>::value,
+            "variant_vector cannot contain rvalue references.");
+    };
+
+    typedef meta::vector <typename sanity_check <Types>::dummy ...>
+        trigger_sanity_check;
+
+    static const std::size_t type_num = sizeof ... (Types);
+
+    std::vector <which_type> tags_;
+    /**
+    For each checkpoint, that is, for every checkpoint_interval elements,
+    the numbers of elements of each type before it.
+    */
+    std::vector <std::size_t> checkpoints_;
+    std::tuple <typename variant_detail::column_of <Types>::type ...>
+        columns_;
+
+public:
+    variant_vector() {}
+
+    std::size_t size() const { return tags_.size(); }
+    bool empty() const { return tags_.empty(); }
+
+    void reserve (std::size_t new_capacity) {
+        tags_.reserve (new_capacity);
+        checkpoints_.reserve (
+            (new_capacity / checkpoint_interval + 1) * type_num);
+    }
+
+    void clear() {
+        tags_.clear();
+        checkpoints_.clear();
+        columns_ = std::tuple <typename variant_detail::column_of <Types>::type
+            ...>();
+    }
+
+    /**
+    \return The index, in the template parameter list, of the type of element
+    \a index.
+    */
+    std::size_t which (std::size_t index) const {
+        assert (index < size());
+        return tags_ [index];
+    }
+
+    /**
+    \return The column of values of type \a Type, in the order in which they
+    were inserted.
+    For reference types, this contains the stored form of the references.
+    */
+    template <class Type>
+        typename variant_detail::column_of <Type>::type const & column() const
+    { return std::get <base_type::template index_of <Type>::value> (columns_); }
+
+private:
+    /**
+    Append an element whose type has index Index and whose stored value has
+    already been appended to its column, or void.
+    If this throws, it removes the last element from the column, if any.
+    */
+    template <std::size_t Index> void append_tag() {
+        std::size_t const checkpoint_size = checkpoints_.size();
+        try {
+            if (tags_.size() % checkpoint_interval == 0)
+                add_checkpoint();
+            tags_.push_back (which_type (Index));
+        } catch (...) {
+            checkpoints_.resize (checkpoint_size);
+            pop_column <Index>();
+            throw;
+        }
+    }
+
+    /**
+    Append a checkpoint for the current end, from the previous checkpoint
+    and the types of the elements since.
+    */
+    void add_checkpoint() {
+        std::size_t const previous = checkpoints_.size();
+        checkpoints_.resize (previous + type_num);
+        if (previous != 0) {
+            std::copy (checkpoints_.begin() + (previous - type_num),
+                checkpoints_.begin() + previous,
+                checkpoints_.begin() + previous);
+            for (std::size_t index = tags_.size() - checkpoint_interval;
+                    index != tags_.size(); ++ index)
+                ++ checkpoints_ [previous + tags_ [index]];
+        }
+    }
+
+    /**
+    \return The position of element \a index in its column.
+    */
+    std::size_t position (std::size_t index) const {
+        std::size_t const checkpoint = index / checkpoint_interval;
+        which_type const which = tags_ [index];
+        std::size_t result = checkpoints_ [checkpoint * type_num + which];
+        for (std::size_t other = checkpoint * checkpoint_interval;
+                other != index; ++ other)
+            result += (tags_ [other] == which);
+        return result;
+    }
+
+    template <std::size_t Index> void pop_column()
+    { pop_column (std::get <Index> (columns_)); }
+
+    template <class Column> static void pop_column (Column & column)
+    { column.pop_back(); }
+    static void pop_column (variant_detail::no_column &) {}
+
+    template <class Type, class ... Arguments>
+        typename boost::disable_if <std::is_void <Type>>::type
+        emplace_back_as (Arguments && ... arguments)
+    {
+        static const std::size_t index
+            = base_type::template index_of <Type>::value;
+        std::get <index> (columns_).emplace_back (
+            std::forward <Arguments> (arguments) ...);
+        append_tag <index>();
+    }
+
+    template <class Type>
+        typename boost::enable_if <std::is_void <Type>>::type
+        emplace_back_as()
+    { append_tag <base_type::template index_of <void>::value>(); }
+
+    /**
+    Append the contents of a variant.
+    This is called when it turns out, at run time, that that_variant
+    contains an object of type Actual.
+    */
+    template <typename Actual, typename Dummy = void>
+        struct push_back_containing
+    {
+        template <class ThatVariant> void operator() (
+            variant_vector & vector, ThatVariant && that_variant) const
+        {
+            vector.push_back (get_unsafe <Actual> (
+                std::forward <ThatVariant> (that_variant)));
+        }
+    };
+    template <typename Dummy> struct push_back_containing <void, Dummy> {
+        template <class ThatVariant> void operator() (
+            variant_vector & vector, ThatVariant && that_variant) const
+        {
+            get_unsafe <void> (std::forward <ThatVariant> (that_variant));
+            vector.template emplace_back_as <void>();
+        }
+    };
+
+    /**
+    Return the address of the object that the element at a position in a
+    column is or refers to.
+    This is called when it turns out, at run time, that the element has type
+    Actual.
+    */
+    template <typename Actual, typename Dummy = void> struct element_address {
+        template <class Columns> void const * operator() (
+            Columns const & columns, std::size_t position) const
+        {
+            auto & column = std::get <
+                base_type::template index_of <Actual>::value> (columns);
+            ::utility::storage::get <Actual,
+                typename std::remove_reference <decltype (column)>::type &>
+                extract;
+            return std::addressof (extract (column [position]));
+        }
+    };
+    template <typename Dummy> struct element_address <void, Dummy> {
+        template <class Columns> void const * operator() (
+            Columns const &, std::size_t) const
+        { return nullptr; }
+    };
+
+    template <class Reference> Reference get_reference (std::size_t index)
+        const
+    {
+        typedef meta::vector <element_address <Types> ...> specialisations;
+        ::rime::detail::switch_ <void const *, specialisations,
+            dispatch_policy_type> s;
+        std::size_t which = tags_ [index];
+        return variant_detail::variant_ref_access::make <Reference> (
+            s (which, columns_, position (index)), which);
+    }
+
+    /**
+    Call a function on all elements in one column.
+    */
+    template <std::size_t Index, class Type> struct visit_column {
+        template <class Function, class Columns>
+            static void call (Function && function, Columns & columns)
+        {
+            auto & column = std::get <Index> (columns);
+            ::utility::storage::get <Type,
+                typename std::remove_reference <decltype (column)>::type &>
+                extract;
+            for (auto & element : column)
+                function (extract (element));
+        }
+    };
+    template <std::size_t Index> struct visit_column <Index, void> {
+        template <class Function, class Columns>
+            static void call (Function &&, Columns &) {}
+    };
+
+    template <class NumberedTypes> struct visit_columns;
+
+    template <class ... NumberedTypes>
+        struct visit_columns <meta::vector <NumberedTypes ...>>
+    {
+        template <class Function, class Columns>
+            static void call (Function && function, Columns & columns)
+        {
+            int dummy [] = { (visit_column <
+                    mpl::first <NumberedTypes>::type::value,
+                    typename mpl::second <NumberedTypes>::type
+                >::call (function, columns), 0) ..., 0 };
+            (void) dummy;
+        }
+    };
+
+public:
+    /**
+    Append an element that is not a variant.
+    This selects the type to store in the same way as the constructor of
+    variant <Types...>.
+    */
+    template <typename Actual>
+        typename boost::disable_if <is_variant <Actual>>::type
+        push_back (Actual && actual,
+            // Trigger assertion here already.
+            int = typename base_type::template conversion_for <Actual>
+                ::assert_unambiguous::dummy())
+    {
+        typedef typename base_type::template conversion_for <Actual>
+            ::numbered_candidates numbered_candidates;
+        typedef typename meta::first <numbered_candidates>::type
+            interpretation;
+        emplace_back_as <typename mpl::second <interpretation>::type> (
+            std::forward <Actual> (actual));
+    }
+
+    /**
+    Append the contents of a variant.
+    Each type that the variant can contain must be convertible to exactly one
+    of Types.
+    */
+    template <typename ThatVariant>
+        typename boost::enable_if <is_variant <ThatVariant>>::type
+        push_back (ThatVariant && that,
+            int = typename base_type::template conversion_for_contained_types <
+                ThatVariant>::dummy())
+    {
+        typedef meta::transform <push_back_containing <boost::mpl::_>,
+            typename variant_types <ThatVariant>::type> specialisations;
+        ::rime::detail::switch_ <void, specialisations, dispatch_policy_type>
+            s;
+        s (that.which(), *this, std::forward <ThatVariant> (that));
+    }
+
+    /**
+    Construct an element of type \a Type at the end from \a arguments.
+    */
+    template <class Type, class ... Arguments>
+        typename boost::enable_if <meta::contains <Type, types>>::type
+        emplace_back (Arguments && ... arguments)
+    { emplace_back_as <Type> (std::forward <Arguments> (arguments) ...); }
+
+    /**
+    \return A variant_ref to element \a index.
+    This takes time linear in checkpoint_interval.
+    */
+    reference operator[] (std::size_t index) {
+        assert (index < size());
+        return get_reference <reference> (index);
+    }
+
+    const_reference operator[] (std::size_t index) const {
+        assert (index < size());
+        return get_reference <const_reference> (index);
+    }
+
+    /**
+    Call \a function with every element that is not void, as a reference to
+    the element.
+    The function is called for all elements of the first type, then for all
+    elements of the second type, et cetera.
+    Within each type, the elements are visited in the order in which they were
+    inserted.
+    */
+    template <class Function> void visit_all (Function && function) {
+        visit_columns <typename base_type::numbered_types>::call (
+            function, columns_);
+    }
+
+    template <class Function> void visit_all (Function && function) const {
+        visit_columns <typename base_type::numbered_types>::call (
+            function, columns_);
+    }
+};
+
+} // namespace rime
+
+#endif // RIME_VARIANT_VECTOR_HPP_INCLUDED
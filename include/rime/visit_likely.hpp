@@ -0,0 +1,203 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Visit a variant that is expected to contain one of a few types.
+
+rime::visit calls the function through a switch_, which with the default
+policy is an indirect call through a table of function pointers.
+If a variant almost always contains, say, int, it is faster to compare which()
+with the index of int, and call the function for int directly, so that it can
+be inlined.
+visit_likely does this for the types it is given, in order, and only for other
+types falls back to visit, in a function that is not inlined.
+*/
+
+#ifndef RIME_VISIT_LIKELY_HPP_INCLUDED
+#define RIME_VISIT_LIKELY_HPP_INCLUDED
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <boost/mpl/size_t.hpp>
+
+#include "meta/vector.hpp"
+#include "meta/contains.hpp"
+
+#include "rime/variant.hpp"
+#include "rime/dispatch_policy.hpp"
+#include "rime/detail/compiler.hpp"
+#include "rime/detail/variant_dispatch.hpp"
+
+namespace rime {
+
+namespace variant_detail {
+
+    /**
+    The index of Type in the meta::vector Types.
+    */
+    template <class Type, class Types> struct likely_index;
+
+    template <class Type, class ... Rest>
+        struct likely_index <Type, meta::vector <Type, Rest ...>>
+    : boost::mpl::size_t <0> {};
+
+    template <class Type, class First, class ... Rest>
+        struct likely_index <Type, meta::vector <First, Rest ...>>
+    : boost::mpl::size_t <
+        likely_index <Type, meta::vector <Rest ...>>::value + 1> {};
+
+    /**
+    Compare the index of the contained type with each of the likely types in
+    turn, and call the function directly if it matches.
+    Otherwise, call visit from a function that is not inlined.
+    */
+    template <class Result, class Function, class Variant, class Likely,
+        class DispatchPolicy>
+    struct likely_dispatch;
+
+    template <class Result, class Function, class Variant,
+        class DispatchPolicy>
+    struct likely_dispatch <Result, Function, Variant, meta::vector<>,
+        DispatchPolicy>
+    {
+        RIME_DETAIL_NOINLINE static Result call (
+            Function && function, Variant && variant)
+        {
+            return ::rime::visit <DispatchPolicy> (
+                std::forward <Function> (function)) (
+                std::forward <Variant> (variant));
+        }
+    };
+
+    template <class Result, class Function, class Variant,
+        class First, class ... Rest, class DispatchPolicy>
+    struct likely_dispatch <Result, Function, Variant,
+        meta::vector <First, Rest ...>, DispatchPolicy>
+    {
+        typedef typename variant_types <Variant>::type types;
+
+        static_assert (meta::contains <First, types>::value,
+            "The likely type must be one of the types of the variant.");
+
+        typedef convert_result <Result, dispatch_recipient <
+            meta::vector <Function, Variant>,
+            meta::vector <Function, First>>> recipient;
+
+        static Result call (Function && function, Variant && variant) {
+            if (RIME_DETAIL_LIKELY (
+                    variant.which() == likely_index <First, types>::value))
+            {
+                recipient call_first;
+                return call_first (std::forward <Function> (function),
+                    std::forward <Variant> (variant));
+            }
+            return likely_dispatch <Result, Function, Variant,
+                meta::vector <Rest ...>, DispatchPolicy>::call (
+                    std::forward <Function> (function),
+                    std::forward <Variant> (variant));
+        }
+    };
+
+} // namespace variant_detail
+
+/**
+Function wrapper that calls a function with the actual type of a variant,
+checking first for the types in Likely.
+Use visit_likely to construct this.
+*/
+template <class Likely, class Function, class DispatchPolicy>
+    class likely_visitor
+{
+    Function function;
+
+    template <class CallFunction, class Variant> struct result {
+        typedef decltype (::rime::visit <DispatchPolicy> (
+                std::declval <CallFunction>()) (std::declval <Variant>()))
+            type;
+    };
+
+public:
+    likely_visitor (Function && function) : function (function) {}
+
+    template <class Variant>
+        typename result <Function, Variant>::type
+    operator() (Variant && variant) {
+        return variant_detail::likely_dispatch <
+            typename result <Function, Variant>::type, Function, Variant,
+            Likely, DispatchPolicy>::call (
+                std::forward <Function> (function),
+                std::forward <Variant> (variant));
+    }
+
+    template <class Variant>
+        typename result <Function const, Variant>::type
+    operator() (Variant && variant) const {
+        return variant_detail::likely_dispatch <
+            typename result <Function const, Variant>::type, Function const,
+            Variant, Likely, DispatchPolicy>::call (
+                std::forward <Function const> (function),
+                std::forward <Variant> (variant));
+    }
+};
+
+/**
+Return a function wrapper that, like visit, calls \a function with the actual
+type of the variant that is passed in.
+However, it first compares the contained type with each of \a Likely in turn,
+and calls \a function directly if it matches.
+This can be inlined into the caller.
+Only if the variant contains any other type, visit is used, from a function
+that is not inlined.
+
+For example,
+\code
+rime::visit_likely <int> (f) (v);
+rime::visit_likely <int, double> (f) (v);
+\endcode
+The result type is the same as that of
+\code
+rime::visit (f) (v);
+\endcode
+
+This is faster than visit if the variant almost always contains one of the
+likely types.
+If it does not, it is slower, since all the comparisons will have to be made
+before the generic dispatch.
+
+Unlike visit, this takes exactly one argument, which must be a variant.
+The function itself cannot be a variant.
+To use a different dispatch policy for the types that are not likely, use
+likely_visitor directly.
+
+\tparam Likely
+    The types to check for, in order.
+    These must be types of the variant exactly as they are listed in it.
+*/
+template <class ... Likely, class Function>
+inline likely_visitor <meta::vector <Likely ...>, Function,
+    dispatch_policy::default_policy>
+    visit_likely (Function && function)
+{
+    return likely_visitor <meta::vector <Likely ...>, Function,
+        dispatch_policy::default_policy> (std::forward <Function> (function));
+}
+
+} // namespace rime
+
+#endif // RIME_VISIT_LIKELY_HPP_INCLUDED
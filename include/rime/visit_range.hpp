@@ -0,0 +1,207 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Visit all variants in a range, dispatching once per contained type or once per
+run of consecutive elements that contain the same type, instead of once per
+element.
+*/
+
+#ifndef RIME_VISIT_RANGE_HPP_INCLUDED
+#define RIME_VISIT_RANGE_HPP_INCLUDED
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+#include "meta/vector.hpp"
+
+#include "rime/variant.hpp"
+#include "rime/dispatch_policy.hpp"
+#include "rime/detail/switch.hpp"
+#include "rime/detail/variant_dispatch.hpp"
+
+namespace rime {
+
+/**
+This namespace contains tags that select the order in which visit_range calls
+the function.
+*/
+namespace visit_order {
+
+    /**
+    Visit all elements that contain the first type, then all elements that
+    contain the second type, et cetera.
+    Within each type, the elements are visited in order.
+    This makes one pass over the range per type, in which the test on the
+    contained type is predictable and the call is resolved at compile time.
+    The order of the calls is different from the order of the elements.
+    */
+    struct grouped {};
+
+    /**
+    Visit the elements in order, but dispatch only once per run of consecutive
+    elements that contain the same type.
+    This is useful if the order of side effects matters, and helps most if
+    the runs are long.
+    */
+    struct sequential {};
+
+} // namespace visit_order
+
+namespace variant_detail {
+
+    /**
+    Call the function on one element, of which it is known at compile time
+    that it contains Actual.
+    This uses dispatch_recipient, so that the call is the same as with
+    rime::visit, including for void.
+    */
+    template <class Function, class Iterator, class Actual>
+        struct visit_range_element
+    {
+        typedef typename std::iterator_traits <Iterator>::reference reference;
+        typedef dispatch_recipient <meta::vector <Function &, reference>,
+            meta::vector <Function &, Actual>> recipient;
+
+        static void call (Function & function, Iterator element)
+        { recipient() (function, *element); }
+    };
+
+    /**
+    Call the function on a run of elements that all contain Actual.
+    */
+    template <class Function, class Iterator, class Actual>
+        struct visit_range_run
+    {
+        void operator() (Function & function, Iterator first, Iterator last)
+            const
+        {
+            for (; first != last; ++ first)
+                visit_range_element <Function, Iterator, Actual>::call (
+                    function, first);
+        }
+    };
+
+    template <class Order, class Function, class Iterator, class Types>
+        struct visit_range_impl;
+
+    template <class Function, class Iterator, class ... Types>
+        struct visit_range_impl <visit_order::sequential, Function, Iterator,
+            meta::vector <Types ...>>
+    {
+        typedef typename std::decay <
+            typename std::iterator_traits <Iterator>::reference>::type
+            variant_type;
+        typedef typename variant_dispatch_policy <variant_type>::type
+            dispatch_policy_type;
+
+        static void call (Function & function, Iterator first, Iterator last)
+        {
+            ::rime::detail::switch_ <void,
+                meta::vector <visit_range_run <Function, Iterator, Types> ...>,
+                dispatch_policy_type> s;
+            while (first != last) {
+                std::size_t which = (*first).which();
+                Iterator run_end = first;
+                ++ run_end;
+                while (run_end != last && (*run_end).which() == which)
+                    ++ run_end;
+                s (which, function, first, run_end);
+                first = run_end;
+            }
+        }
+    };
+
+    template <class Function, class Iterator, class ... Types>
+        struct visit_range_impl <visit_order::grouped, Function, Iterator,
+            meta::vector <Types ...>>
+    {
+        /**
+        Make one pass over [first, last) for each type, starting with the
+        type with index Index, and call the function on the elements that
+        contain it.
+        */
+        template <std::size_t Index, class ... Remaining> struct visit_groups;
+
+        template <std::size_t Index, class First, class ... Remaining>
+            struct visit_groups <Index, First, Remaining ...>
+        {
+            static void call (Function & function, Iterator first,
+                Iterator last)
+            {
+                for (Iterator current = first; current != last; ++ current)
+                    if ((*current).which() == Index)
+                        visit_range_element <Function, Iterator, First>::call (
+                            function, current);
+                visit_groups <Index + 1, Remaining ...>::call (
+                    function, first, last);
+            }
+        };
+
+        template <std::size_t Index> struct visit_groups <Index> {
+            static void call (Function &, Iterator, Iterator) {}
+        };
+
+        static void call (Function & function, Iterator first, Iterator last)
+        { visit_groups <0, Types ...>::call (function, first, last); }
+    };
+
+} // namespace variant_detail
+
+/**
+Call \a function on each of the variants in [first, last), like
+    rime::visit (function) (*i)
+but with the dispatch on the contained type hoisted out of the loop.
+Calling rime::visit on each element in turn causes one unpredictable branch
+per element.
+visit_range instead calls \a function in a tight loop, in which the call is
+resolved at compile time and can be inlined.
+No memory is allocated.
+
+\tparam Order
+    visit_order::grouped (the default) to make one pass over the range for
+    each type, and visit the elements that contain it, which helps whatever
+    the order of the types;
+    or visit_order::sequential to keep the order of the calls the same as the
+    order of the elements, and dispatch once per run of consecutive elements
+    that contain the same type, which helps most if the runs are long.
+\param function
+    The function to call on each element.
+    Its return values are ignored.
+\param first
+    Forward iterator to the first element.
+    The value type must be a variant.
+\param last
+    Iterator past the last element.
+*/
+template <class Order = visit_order::grouped, class Function, class Iterator>
+    inline void visit_range (Function && function, Iterator first,
+        Iterator last)
+{
+    typedef typename std::iterator_traits <Iterator>::reference reference;
+    static_assert (is_variant <reference>::value,
+        "visit_range requires a range of variants.");
+    variant_detail::visit_range_impl <Order,
+        typename std::remove_reference <Function>::type, Iterator,
+        typename variant_types <reference>::type>::call (
+            function, first, last);
+}
+
+} // namespace rime
+
+#endif // RIME_VISIT_RANGE_HPP_INCLUDED
@@ -0,0 +1,387 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Visit a number of variants, dispatching on one argument at a time, and call
+the function only for the combinations of types that it declares to support.
+
+rime::visit dispatches on all arguments at once, through one linear switch
+over all combinations of contained types, in which every combination is
+instantiated.
+For three variants with eight types each, this is 512 calls and a table with
+512 entries, even if the function is interesting for only a few of them.
+visit_sparse dispatches on the first argument, then on the second, et cetera,
+through one small switch for each argument.
+Only combinations that are listed are instantiated; any other combination
+goes to one fallback function, which receives the original arguments.
+*/
+
+#ifndef RIME_VISIT_SPARSE_HPP_INCLUDED
+#define RIME_VISIT_SPARSE_HPP_INCLUDED
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <boost/utility/enable_if.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/and.hpp>
+#include <boost/mpl/or.hpp>
+#include <boost/mpl/if.hpp>
+
+#include "meta/vector.hpp"
+#include "meta/flatten.hpp"
+
+#include "rime/variant.hpp"
+#include "rime/dispatch_policy.hpp"
+#include "rime/detail/switch.hpp"
+#include "rime/detail/variant_dispatch.hpp"
+
+namespace rime {
+
+namespace variant_detail {
+
+    /**
+    Compile-time constant that is true iff the actual types in Prefix are
+    the first types of Combination.
+    Types are compared after std::decay, so that "int" in a combination
+    matches "int", "int &", and "int const &" in a variant.
+    */
+    template <class Prefix, class Combination> struct is_prefix_of
+    : boost::mpl::false_ {};
+
+    template <class ... Types> struct is_prefix_of <
+        meta::vector<>, meta::vector <Types ...>>
+    : boost::mpl::true_ {};
+
+    template <class First, class ... Rest,
+            class FirstListed, class ... RestListed>
+        struct is_prefix_of <meta::vector <First, Rest ...>,
+            meta::vector <FirstListed, RestListed ...>>
+    : boost::mpl::and_ <
+        std::is_same <typename std::decay <First>::type,
+            typename std::decay <FirstListed>::type>,
+        is_prefix_of <meta::vector <Rest ...>, meta::vector <RestListed ...>>>
+    {};
+
+    /**
+    Compile-time constant that is true iff any of Combinations starts with
+    the actual types in Prefix.
+    */
+    template <class Prefix, class Combinations> struct is_listed_prefix;
+
+    template <class Prefix> struct is_listed_prefix <Prefix, meta::vector<>>
+    : boost::mpl::false_ {};
+
+    template <class Prefix, class First, class ... Rest>
+        struct is_listed_prefix <Prefix, meta::vector <First, Rest ...>>
+    : boost::mpl::or_ <is_prefix_of <Prefix, First>,
+        is_listed_prefix <Prefix, meta::vector <Rest ...>>> {};
+
+    /**
+    Return the index of the type that the argument contains, or 0 if it is
+    not a variant.
+    */
+    template <class Argument> inline
+        typename boost::disable_if <is_variant <Argument>, std::size_t>::type
+        argument_which (Argument const &)
+    { return 0; }
+
+    template <class Argument> inline
+        typename boost::enable_if <is_variant <Argument>, std::size_t>::type
+        argument_which (Argument const & argument)
+    { return argument.which(); }
+
+    template <std::size_t Index> struct nth_argument_which {
+        template <class First, class ... Rest>
+            static std::size_t get (First const &, Rest const & ... rest)
+        { return nth_argument_which <Index - 1>::get (rest ...); }
+    };
+
+    template <> struct nth_argument_which <0> {
+        template <class First, class ... Rest>
+            static std::size_t get (First const & first, Rest const & ...)
+        { return argument_which (first); }
+    };
+
+    /// Marker for when the actual types of all arguments are known.
+    struct sparse_complete;
+
+    /**
+    Return the types that argument number Index can contain, or
+    sparse_complete if Index is one past the last argument.
+    */
+    template <std::size_t Index, class ... Arguments> struct nth_argument_types
+    { typedef sparse_complete type; };
+
+    template <std::size_t Index, class First, class ... Rest>
+        struct nth_argument_types <Index, First, Rest ...>
+    : nth_argument_types <Index - 1, Rest ...> {};
+
+    template <class First, class ... Rest>
+        struct nth_argument_types <0, First, Rest ...>
+    : variant_types <First> {};
+
+    template <class Arguments, class Prefix> struct sparse_next_types;
+
+    template <class ... Arguments, class ... Actuals>
+        struct sparse_next_types <
+            meta::vector <Arguments ...>, meta::vector <Actuals ...>>
+    : nth_argument_types <sizeof ... (Actuals), Arguments ...> {};
+
+    /**
+    Dispatch on the argument after the ones whose actual types are in Prefix.
+
+    Each level exposes:
+    \li result_types, a meta::vector of the result types of all calls that it
+        can make;
+    \li choice <Result, DispatchPolicy>, a class whose operator() takes the
+        function, the fallback, and the arguments, and returns Result.
+    */
+    template <class Combinations, class Function, class Fallback,
+        class Arguments, class Prefix,
+        class NextTypes =
+            typename sparse_next_types <Arguments, Prefix>::type>
+    struct sparse_dispatch;
+
+    /**
+    Call the fallback with the original arguments.
+    */
+    template <class Function, class Fallback, class Arguments>
+        struct sparse_fallback;
+
+    template <class Function, class Fallback, class ... Arguments>
+        struct sparse_fallback <Function, Fallback, meta::vector <Arguments ...>>
+    {
+        struct recipient {
+            typedef decltype (std::declval <Fallback &&>() (
+                std::declval <Arguments &&>() ...)) result_type;
+
+            result_type operator() (
+                Fallback && fallback, Arguments && ... arguments) const
+            {
+                return std::forward <Fallback> (fallback) (
+                    std::forward <Arguments> (arguments) ...);
+            }
+        };
+
+        typedef meta::vector <typename recipient::result_type> result_types;
+
+        template <class Result, class DispatchPolicy> struct choice {
+            Result operator() (Function &&, Fallback && fallback,
+                Arguments && ... arguments) const
+            {
+                convert_result <Result, recipient> call;
+                return call (std::forward <Fallback> (fallback),
+                    std::forward <Arguments> (arguments) ...);
+            }
+        };
+    };
+
+    /**
+    Go on to the next argument if some combination starts with Prefix, and
+    call the fallback otherwise.
+    */
+    template <class Combinations, class Function, class Fallback,
+        class Arguments, class Prefix>
+    struct sparse_next
+    : boost::mpl::if_ <is_listed_prefix <Prefix, Combinations>,
+        sparse_dispatch <Combinations, Function, Fallback, Arguments, Prefix>,
+        sparse_fallback <Function, Fallback, Arguments>> {};
+
+    // The actual types of all arguments are known: call the function.
+    template <class Combinations, class Function, class Fallback,
+        class ... Arguments, class ... Actuals>
+    struct sparse_dispatch <Combinations, Function, Fallback,
+        meta::vector <Arguments ...>, meta::vector <Actuals ...>,
+        sparse_complete>
+    {
+        typedef dispatch_recipient <meta::vector <Function, Arguments ...>,
+            meta::vector <Function, Actuals ...>> recipient;
+
+        typedef meta::vector <typename recipient::result_type> result_types;
+
+        template <class Result, class DispatchPolicy> struct choice {
+            Result operator() (Function && function, Fallback &&,
+                Arguments && ... arguments) const
+            {
+                convert_result <Result, recipient> call;
+                return call (std::forward <Function> (function),
+                    std::forward <Arguments> (arguments) ...);
+            }
+        };
+    };
+
+    // Dispatch on the next argument.
+    template <class Combinations, class Function, class Fallback,
+        class ... Arguments, class ... Actuals, class ... NextTypes>
+    struct sparse_dispatch <Combinations, Function, Fallback,
+        meta::vector <Arguments ...>, meta::vector <Actuals ...>,
+        meta::vector <NextTypes ...>>
+    {
+        template <class NextType> struct next
+        : sparse_next <Combinations, Function, Fallback,
+            meta::vector <Arguments ...>,
+            meta::vector <Actuals ..., NextType>>::type {};
+
+        typedef typename meta::as_vector <typename meta::flatten <
+                meta::vector <typename next <NextTypes>::result_types ...>
+            >::type>::type result_types;
+
+        template <class Result, class DispatchPolicy> struct choice {
+            Result operator() (Function && function, Fallback && fallback,
+                Arguments && ... arguments) const
+            {
+                ::rime::detail::switch_ <Result, meta::vector <
+                        typename next <NextTypes>::template choice <
+                            Result, DispatchPolicy> ...>,
+                    DispatchPolicy> s;
+                return s (
+                    nth_argument_which <sizeof ... (Actuals)>::get (
+                        arguments ...),
+                    std::forward <Function> (function),
+                    std::forward <Fallback> (fallback),
+                    std::forward <Arguments> (arguments) ...);
+            }
+        };
+    };
+
+    template <class Combinations, class Function, class Fallback,
+        class Arguments, class DispatchPolicy>
+    struct sparse_dispatcher;
+
+    template <class Combinations, class Function, class Fallback,
+        class ... Arguments, class DispatchPolicy>
+    struct sparse_dispatcher <Combinations, Function, Fallback,
+        meta::vector <Arguments ...>, DispatchPolicy>
+    {
+        typedef sparse_dispatch <Combinations, Function, Fallback,
+            meta::vector <Arguments ...>, meta::vector<>> root;
+
+        /**
+        Merge the result types of the listed combinations and of the
+        fallback into one (potentially variant) type.
+        */
+        typedef typename make_variant_over <typename root::result_types>::type
+            result_type;
+
+        result_type operator() (Function && function, Fallback && fallback,
+            Arguments && ... arguments) const
+        {
+            typename root::template choice <result_type, DispatchPolicy> call;
+            return call (std::forward <Function> (function),
+                std::forward <Fallback> (fallback),
+                std::forward <Arguments> (arguments) ...);
+        }
+    };
+
+} // namespace variant_detail
+
+/**
+Function wrapper that dispatches on its arguments one at a time, and calls
+the function only for the listed combinations of types.
+Use visit_sparse to construct this.
+*/
+template <class Combinations, class Function, class Fallback,
+    class DispatchPolicy>
+class sparse_visitor {
+    Function function;
+    Fallback fallback;
+
+public:
+    sparse_visitor (Function && function, Fallback && fallback)
+    : function (function), fallback (fallback) {}
+
+    template <typename ... Arguments>
+    typename variant_detail::sparse_dispatcher <Combinations,
+        Function, Fallback, meta::vector <Arguments ...>, DispatchPolicy
+    >::result_type
+    operator() (Arguments && ... arguments) {
+        variant_detail::sparse_dispatcher <Combinations, Function, Fallback,
+            meta::vector <Arguments ...>, DispatchPolicy> dispatcher;
+        return dispatcher (std::forward <Function> (function),
+            std::forward <Fallback> (fallback),
+            std::forward <Arguments> (arguments) ...);
+    }
+
+    template <typename ... Arguments>
+    typename variant_detail::sparse_dispatcher <Combinations,
+        Function const, Fallback const, meta::vector <Arguments ...>,
+        DispatchPolicy
+    >::result_type
+    operator() (Arguments && ... arguments) const {
+        variant_detail::sparse_dispatcher <Combinations,
+            Function const, Fallback const, meta::vector <Arguments ...>,
+            DispatchPolicy> dispatcher;
+        return dispatcher (std::forward <Function const> (function),
+            std::forward <Fallback const> (fallback),
+            std::forward <Arguments> (arguments) ...);
+    }
+};
+
+/**
+Return a function wrapper that calls \a function with the actual types of the
+variants that are passed in, like visit, but only for the combinations of
+types in \a Combinations.
+For all other combinations, \a fallback is called with the original arguments,
+including the variants.
+
+For example,
+\code
+typedef meta::vector <
+    meta::vector <int, int>, meta::vector <double, double>> combinations;
+rime::visit_sparse <combinations> (add(), throw_error()) (v1, v2);
+\endcode
+calls add() with two ints or two doubles, and throw_error() with v1 and v2 if
+they contain any other combination of types.
+The variants are dispatched on one by one.
+For v1, the dispatch goes on to v2 only if it contains int or double; for
+other types, it goes straight to the fallback.
+This way, the function is instantiated only for the combinations that are
+listed, and only one instantiation of the fallback is required.
+
+Unlike with visit, the function itself cannot be a variant.
+
+\tparam Combinations
+    A meta::vector of meta::vector's, each of which has one type for each
+    argument.
+    The types are compared with the actual types after std::decay.
+    Non-variant arguments must be listed with their own type.
+    A variant argument that contains void can be listed as void; then, as with
+    visit, it is left out of the call.
+\tparam DispatchPolicy
+    The dispatch policy that is used for each of the arguments.
+\param function The function to call for the listed combinations.
+\param fallback The function to call for other combinations.
+\return
+    The result of the call.
+    If the function and the fallback return different types, this is a
+    variant.
+*/
+template <class Combinations,
+    class DispatchPolicy = dispatch_policy::default_policy,
+    class Function, class Fallback>
+inline sparse_visitor <Combinations, Function, Fallback, DispatchPolicy>
+    visit_sparse (Function && function, Fallback && fallback)
+{
+    return sparse_visitor <Combinations, Function, Fallback, DispatchPolicy> (
+        std::forward <Function> (function), std::forward <Fallback> (fallback));
+}
+
+} // namespace rime
+
+#endif // RIME_VISIT_SPARSE_HPP_INCLUDED
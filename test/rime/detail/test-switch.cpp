@@ -17,6 +17,8 @@ limitations under the License.
 #define BOOST_TEST_MODULE test_rime_detail_switch
 #include "utility/test/boost_unit_test.hpp"
 
+#include <type_traits>
+
 #include <boost/mpl/assert.hpp>
 
 #include "rime/detail/switch.hpp"
@@ -45,5 +47,73 @@ BOOST_AUTO_TEST_CASE (test_rime_detail_switch) {
     BOOST_CHECK_EQUAL (s (2, 11), 77.);
 }
 
+template <int factor> struct struct_times {
+    int operator() (int i) const { return factor * i; }
+};
+
+template <class Policy> void check_policy() {
+    {
+        switch_ <int, meta::vector <struct_times <1>>, Policy> s;
+        BOOST_CHECK_EQUAL (s (0, 3), 3);
+    }
+    {
+        switch_ <int, meta::vector <struct_times <1>, struct_times <2>>,
+            Policy> s;
+        BOOST_CHECK_EQUAL (s (0, 3), 3);
+        BOOST_CHECK_EQUAL (s (1, 3), 6);
+    }
+    {
+        // More alternatives than fit in one switch statement.
+        switch_ <int, meta::vector <
+            struct_times <1>, struct_times <2>, struct_times <3>,
+            struct_times <4>, struct_times <5>, struct_times <6>,
+            struct_times <7>, struct_times <8>, struct_times <9>,
+            struct_times <10>, struct_times <11>, struct_times <12>,
+            struct_times <13>, struct_times <14>, struct_times <15>,
+            struct_times <16>, struct_times <17>, struct_times <18>>,
+            Policy> s;
+        for (int i = 0; i != 18; ++ i)
+            BOOST_CHECK_EQUAL (s (i, 3), 3 * (i + 1));
+    }
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_detail_switch_policies) {
+    check_policy <rime::dispatch_policy::table>();
+    check_policy <rime::dispatch_policy::switch_statement>();
+    check_policy <rime::dispatch_policy::if_chain>();
+    check_policy <rime::dispatch_policy::automatic>();
+    check_policy <rime::dispatch_policy::default_policy>();
+    check_policy <rime::dispatch_policy::hot_first <
+        rime::dispatch_policy::table, 1, 0>>();
+    // Index 16 is out of range for some of the switches.
+    check_policy <rime::dispatch_policy::hot_first <
+        rime::dispatch_policy::switch_statement, 16, 1>>();
+
+    BOOST_MPL_ASSERT ((std::is_same <
+        rime::dispatch_policy::by_size <2, 4>::apply <2>::type,
+        rime::dispatch_policy::if_chain>));
+    BOOST_MPL_ASSERT ((std::is_same <
+        rime::dispatch_policy::by_size <2, 4>::apply <3>::type,
+        rime::dispatch_policy::switch_statement>));
+    BOOST_MPL_ASSERT ((std::is_same <
+        rime::dispatch_policy::by_size <2, 4>::apply <5>::type,
+        rime::dispatch_policy::table>));
+    // The defaults.
+    BOOST_MPL_ASSERT ((std::is_same <
+        rime::dispatch_policy::automatic::apply <4>::type,
+        rime::dispatch_policy::if_chain>));
+    BOOST_MPL_ASSERT ((std::is_same <
+        rime::dispatch_policy::automatic::apply <5>::type,
+        rime::dispatch_policy::switch_statement>));
+    BOOST_MPL_ASSERT ((std::is_same <
+        rime::dispatch_policy::automatic::apply <17>::type,
+        rime::dispatch_policy::table>));
+    BOOST_MPL_ASSERT ((std::is_same <
+        rime::dispatch_policy::hot_first <
+            rime::dispatch_policy::by_size <2, 4>, 2, 0>::apply <5>::type,
+        rime::dispatch_policy::hot_first <
+            rime::dispatch_policy::table, 2, 0>>));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -199,5 +199,50 @@ BOOST_AUTO_TEST_CASE (test_rime_detail_dispatch_recipient) {
     }
 }
 
+// Recipients whose arguments convert to the same types share the call.
+BOOST_AUTO_TEST_CASE (test_rime_detail_dispatch_call) {
+    using rime::variant_detail::dispatch_recipient_no_void;
+    using rime::variant_detail::dispatch_call;
+    {
+        typedef meta::vector <function &, rime::variant <int &, int> &>
+            arguments_type;
+        typedef dispatch_recipient_no_void <arguments_type,
+            meta::vector <function &, int &>> reference_recipient;
+        typedef dispatch_recipient_no_void <arguments_type,
+            meta::vector <function &, int>> value_recipient;
+        BOOST_MPL_ASSERT ((std::is_same <reference_recipient::call_type,
+            dispatch_call <function &, int &>>));
+        BOOST_MPL_ASSERT ((std::is_same <value_recipient::call_type,
+            reference_recipient::call_type>));
+
+        function f;
+        int i = 5;
+        rime::variant <int &, int> reference (i);
+        rime::variant <int &, int> value (6);
+        BOOST_CHECK_EQUAL (reference_recipient() (f, reference), 1);
+        BOOST_CHECK_EQUAL (value_recipient() (f, value), 1);
+    }
+    {
+        // Void alternatives of different variants share the call with the
+        // remaining arguments.
+        typedef rime::variant_detail::dispatch_recipient <
+            meta::vector <function &, rime::variant <int, void>>,
+            meta::vector <function &, void>> first_recipient;
+        typedef rime::variant_detail::dispatch_recipient <
+            meta::vector <function &, rime::variant <void, double>>,
+            meta::vector <function &, void>> second_recipient;
+        typedef dispatch_recipient_no_void <meta::vector <function &>,
+            meta::vector <function &>> no_argument_recipient;
+        BOOST_MPL_ASSERT ((std::is_same <no_argument_recipient::call_type,
+            dispatch_call <function &>>));
+
+        function f;
+        BOOST_CHECK_EQUAL (
+            first_recipient() (f, rime::variant <int, void>()), 0);
+        BOOST_CHECK_EQUAL (
+            second_recipient() (f, rime::variant <void, double>()), 0);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
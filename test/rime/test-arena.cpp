@@ -0,0 +1,292 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Test rime::arena, and recursive variants with boxed alternatives in it.
+*/
+
+#define BOOST_TEST_MODULE test_rime_arena
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/arena.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include <boost/mpl/assert.hpp>
+
+#include "rime/variant.hpp"
+#include "rime/boxed.hpp"
+#include "rime/storage_policy.hpp"
+
+BOOST_AUTO_TEST_SUITE(test_rime_arena)
+
+BOOST_AUTO_TEST_CASE (test_rime_arena_allocate) {
+    rime::arena a (64);
+    BOOST_CHECK_EQUAL (a.block_num(), 0u);
+
+    void * p1 = a.allocate (1, 1);
+    void * p2 = a.allocate (8, 8);
+    BOOST_CHECK_EQUAL (a.block_num(), 1u);
+    BOOST_CHECK_EQUAL (reinterpret_cast <std::uintptr_t> (p2) % 8, 0u);
+    BOOST_CHECK (static_cast <char *> (p2) > static_cast <char *> (p1));
+
+    // Does not fit in the current block.
+    a.allocate (60, 4);
+    BOOST_CHECK_EQUAL (a.block_num(), 2u);
+
+    // Larger than a block.
+    void * p3 = a.allocate (200, 16);
+    BOOST_CHECK_EQUAL (a.block_num(), 3u);
+    BOOST_CHECK_EQUAL (reinterpret_cast <std::uintptr_t> (p3) % 16, 0u);
+
+    a.release();
+    BOOST_CHECK_EQUAL (a.block_num(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_arena_allocator) {
+    rime::arena a;
+    rime::arena_allocator <int> int_allocator (a);
+    rime::arena_allocator <double> double_allocator (int_allocator);
+    BOOST_CHECK (int_allocator == double_allocator);
+    BOOST_CHECK_EQUAL (&double_allocator.get_arena(), &a);
+
+    rime::arena other;
+    BOOST_CHECK (int_allocator != rime::arena_allocator <int> (other));
+
+    double * d = double_allocator.allocate (3);
+    d [0] = 1.5;
+    d [2] = 3.5;
+    BOOST_CHECK_EQUAL (d [0] + d [2], 5.);
+    double_allocator.deallocate (d, 3);
+
+    // Skipping destructors is opt-in.
+    BOOST_MPL_ASSERT_NOT ((rime::allocator_releases_all <
+        rime::arena_allocator <int>>));
+    BOOST_MPL_ASSERT ((rime::allocator_releases_all <
+        rime::arena_allocator <int, true>>));
+    BOOST_MPL_ASSERT ((rime::allocator_releases_all <
+        std::allocator_traits <rime::arena_allocator <int, true>>
+            ::rebind_alloc <double>>));
+    BOOST_MPL_ASSERT_NOT ((rime::allocator_releases_all <
+        std::allocator <int>>));
+
+    // Objects that hold other resources are still destructed.
+    typedef rime::boxed <std::string, rime::arena_allocator <std::string>>
+        string_box;
+    BOOST_MPL_ASSERT_NOT ((std::is_trivially_destructible <string_box>));
+    {
+        string_box s (std::allocator_arg,
+            rime::arena_allocator <std::string> (a),
+            "a string that is too long for the small-string optimisation");
+        BOOST_CHECK_EQUAL (s.get().size(), 59u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_arena_scope) {
+    BOOST_CHECK (rime::arena::current() == nullptr);
+    rime::arena a;
+    {
+        rime::arena_scope scope (a);
+        BOOST_CHECK_EQUAL (rime::arena::current(), &a);
+        BOOST_CHECK_EQUAL (&rime::arena_allocator <int>().get_arena(), &a);
+        {
+            rime::arena other;
+            rime::arena_scope inner_scope (other);
+            BOOST_CHECK_EQUAL (rime::arena::current(), &other);
+        }
+        BOOST_CHECK_EQUAL (rime::arena::current(), &a);
+    }
+    BOOST_CHECK (rime::arena::current() == nullptr);
+    BOOST_CHECK_THROW (rime::arena_allocator <int>(), rime::no_current_arena);
+}
+
+struct large { long values [16]; };
+
+typedef rime::variant <int, large> arena_variant;
+
+BOOST_AUTO_TEST_SUITE_END()
+
+namespace rime {
+    template <> struct variant_storage_policy <
+        ::test_rime_arena::arena_variant>
+    {
+        typedef storage_policy::box_larger_than <16,
+            arena_allocator <void, true>> type;
+    };
+} // namespace rime
+
+BOOST_AUTO_TEST_SUITE(test_rime_arena)
+
+// A variant whose storage policy boxes with arena_allocator.
+BOOST_AUTO_TEST_CASE (test_rime_arena_storage_policy) {
+    BOOST_MPL_ASSERT ((std::is_trivially_destructible <arena_variant>));
+    static_assert (sizeof (arena_variant) < sizeof (large),
+        "The large alternative should be boxed.");
+
+    rime::arena a;
+    rime::arena_scope scope (a);
+
+    large l = large();
+    l.values [0] = 5;
+    arena_variant v (l);
+    BOOST_CHECK_EQUAL (a.block_num(), 1u);
+    BOOST_CHECK_EQUAL (rime::get <large> (v).values [0], 5);
+
+    arena_variant copy (v);
+    rime::get <large> (copy).values [0] = 6;
+    BOOST_CHECK_EQUAL (rime::get <large> (v).values [0], 5);
+    BOOST_CHECK_EQUAL (rime::get <large> (copy).values [0], 6);
+
+    arena_variant moved (std::move (copy));
+    BOOST_CHECK_EQUAL (rime::get <large> (moved).values [0], 6);
+    BOOST_CHECK_EQUAL (a.block_num(), 1u);
+}
+
+// Copying and moving use the allocator of the source, not the current arena.
+BOOST_AUTO_TEST_CASE (test_rime_arena_storage_policy_copy) {
+    rime::arena a;
+    rime::arena other;
+
+    large l = large();
+    l.values [0] = 7;
+    std::unique_ptr <arena_variant> v;
+    {
+        rime::arena_scope scope (a);
+        v.reset (new arena_variant (l));
+    }
+    BOOST_CHECK_EQUAL (a.block_num(), 1u);
+
+    // Without a current arena.
+    arena_variant copy (*v);
+    BOOST_CHECK_EQUAL (rime::get <large> (copy).values [0], 7);
+    arena_variant moved (std::move (copy));
+    BOOST_CHECK_EQUAL (rime::get <large> (moved).values [0], 7);
+
+    // With a different current arena.
+    {
+        rime::arena_scope scope (other);
+        arena_variant copy (*v);
+        BOOST_CHECK_EQUAL (rime::get <large> (copy).values [0], 7);
+    }
+    BOOST_CHECK_EQUAL (other.block_num(), 0u);
+}
+
+/*
+Recursive expression tree.
+*/
+
+int destruction_num = 0;
+
+template <class Allocator> struct binary;
+
+template <class Allocator> struct expression {
+    typedef rime::boxed <binary <Allocator>,
+        typename std::allocator_traits <Allocator>::template rebind_alloc <
+            binary <Allocator>>> box_type;
+    typedef rime::variant <int, box_type> type;
+};
+
+template <class Allocator> struct binary {
+    typedef typename expression <Allocator>::type expression_type;
+
+    char operation;
+    expression_type left;
+    expression_type right;
+
+    binary (char operation, expression_type && left,
+        expression_type && right)
+    : operation (operation), left (std::move (left)),
+        right (std::move (right)) {}
+
+    binary (binary const & that)
+    : operation (that.operation), left (that.left), right (that.right) {}
+
+    ~binary() { ++ destruction_num; }
+};
+
+template <class Allocator> struct evaluate {
+    int operator() (int i) const { return i; }
+
+    template <class Box> int operator() (Box const & box) const {
+        binary <Allocator> const & node = box.get();
+        int left = rime::visit (*this) (node.left);
+        int right = rime::visit (*this) (node.right);
+        return node.operation == '+' ? left + right : left * right;
+    }
+};
+
+/**
+Build (1 + 2) * (3 + 4).
+*/
+template <class Allocator> typename expression <Allocator>::type
+    build (Allocator const & allocator)
+{
+    typedef typename expression <Allocator>::type expression_type;
+    typedef typename expression <Allocator>::box_type box_type;
+    typedef typename box_type::allocator_type box_allocator;
+
+    expression_type left (box_type (std::allocator_arg,
+        box_allocator (allocator), '+', expression_type (1),
+        expression_type (2)));
+    expression_type right (box_type (std::allocator_arg,
+        box_allocator (allocator), '+', expression_type (3),
+        expression_type (4)));
+    return expression_type (box_type (std::allocator_arg,
+        box_allocator (allocator), '*', std::move (left), std::move (right)));
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_arena_recursive) {
+    typedef std::allocator <int> heap_allocator;
+    typedef rime::arena_allocator <int, true> arena_allocator;
+
+    BOOST_MPL_ASSERT_NOT ((std::is_trivially_destructible <
+        expression <heap_allocator>::type>));
+    BOOST_MPL_ASSERT ((std::is_trivially_destructible <
+        expression <arena_allocator>::type>));
+
+    destruction_num = 0;
+    {
+        expression <heap_allocator>::type e = build (heap_allocator());
+        BOOST_CHECK_EQUAL (rime::visit (evaluate <heap_allocator>()) (e), 21);
+
+        expression <heap_allocator>::type copy (e);
+        BOOST_CHECK_EQUAL (
+            rime::visit (evaluate <heap_allocator>()) (copy), 21);
+    }
+    // All six nodes are destructed.
+    BOOST_CHECK_EQUAL (destruction_num, 6);
+
+    destruction_num = 0;
+    {
+        rime::arena a;
+        expression <arena_allocator>::type e = build (arena_allocator (a));
+        BOOST_CHECK_EQUAL (
+            rime::visit (evaluate <arena_allocator>()) (e), 21);
+        BOOST_CHECK_EQUAL (a.block_num(), 1u);
+
+        expression <arena_allocator>::type copy (e);
+        BOOST_CHECK_EQUAL (
+            rime::visit (evaluate <arena_allocator>()) (copy), 21);
+    }
+    // The arena releases the memory without destructing the nodes.
+    BOOST_CHECK_EQUAL (destruction_num, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Test rime/dispatch_profile.hpp.
+*/
+
+#define RIME_DISPATCH_PROFILE
+
+#define BOOST_TEST_MODULE test_rime_dispatch_profile
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/dispatch_profile.hpp"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rime/variant.hpp"
+
+BOOST_AUTO_TEST_SUITE(test_rime_dispatch_profile)
+
+struct is_int {
+    bool operator() (int) const { return true; }
+    bool operator() (double) const { return false; }
+};
+
+struct add {
+    int operator() (int i, int j) const { return i + j; }
+    double operator() (double d, int j) const { return d + j; }
+    double operator() (int i, double e) const { return i + e; }
+    double operator() (double d, double e) const { return d + e; }
+};
+
+/**
+\return The number of sites whose counts are exactly \a expected.
+*/
+int count_sites (std::vector <std::uint64_t> const & expected) {
+    int result = 0;
+    for (auto const & site : rime::dispatch_profile::snapshot())
+        if (site.counts == expected)
+            ++ result;
+    return result;
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_dispatch_profile_visit) {
+    typedef rime::variant <int, double> variant;
+    variant i (1);
+    variant d (2.);
+
+    rime::dispatch_profile::reset();
+    rime::visit (is_int()) (d);
+    rime::visit (is_int()) (d);
+    rime::visit (is_int()) (d);
+    rime::visit (is_int()) (i);
+    BOOST_CHECK_EQUAL (count_sites ({1, 3}), 1);
+
+    // The index is the linear index into all combinations.
+    rime::visit (add()) (d, i);
+    rime::visit (add()) (d, i);
+    rime::visit (add()) (i, d);
+    BOOST_CHECK_EQUAL (count_sites ({0, 1, 2, 0}), 1);
+
+    rime::dispatch_profile::reset();
+    BOOST_CHECK_EQUAL (count_sites ({1, 3}), 0);
+    BOOST_CHECK_EQUAL (count_sites ({0, 0}), 1);
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_dispatch_profile_destruct) {
+    typedef rime::variant <int, std::string> variant;
+    rime::dispatch_profile::reset();
+    {
+        variant s (std::string ("a"));
+        variant t (std::string ("b"));
+        variant i (1);
+    }
+    BOOST_CHECK_EQUAL (count_sites ({1, 2}), 1);
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_dispatch_profile_dump) {
+    typedef rime::variant <int, double> variant;
+    rime::dispatch_profile::reset();
+    rime::visit (is_int()) (variant (5));
+
+    std::ostringstream stream;
+    rime::dispatch_profile::dump (stream);
+    BOOST_CHECK (stream.str().find ("    0\t1\t100%") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,126 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Test std::hash for variant, rime::variant_equal_to, and rime::hash_range.
+*/
+
+#define BOOST_TEST_MODULE test_rime_hash
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/hash.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+BOOST_AUTO_TEST_SUITE(test_rime_hash)
+
+typedef rime::variant <int, unsigned, std::string, void> variant;
+
+BOOST_AUTO_TEST_CASE (test_rime_hash_variant) {
+    std::hash <variant> hash;
+
+    BOOST_CHECK_EQUAL (hash (variant (5)), hash (variant (5)));
+    BOOST_CHECK_EQUAL (hash (variant (std::string ("a"))),
+        hash (variant (std::string ("a"))));
+    BOOST_CHECK_EQUAL (hash (variant()), hash (variant()));
+
+    // The index of the type is part of the hash.
+    BOOST_CHECK (hash (variant (0)) != hash (variant()));
+
+    // A variant of references hashes the object it refers to.
+    int i = 5;
+    rime::variant <int &, unsigned> reference (i);
+    BOOST_CHECK_EQUAL (std::hash <rime::variant <int &, unsigned>>() (
+        reference), hash (variant (5)));
+
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_hash_variant_equal_to) {
+    rime::variant_equal_to equal;
+
+    BOOST_CHECK (equal (variant (5), variant (5)));
+    BOOST_CHECK (!equal (variant (5), variant (6)));
+    BOOST_CHECK (equal (variant (std::string ("a")),
+        variant (std::string ("a"))));
+    BOOST_CHECK (!equal (variant (std::string ("a")),
+        variant (std::string ("b"))));
+    BOOST_CHECK (equal (variant(), variant()));
+
+    // Objects of different types are never equal.
+    BOOST_CHECK (!equal (variant (5), variant (5u)));
+    BOOST_CHECK (!equal (variant (0), variant()));
+    BOOST_CHECK (!equal (variant (std::string()), variant()));
+
+    // Mixing in which() into the hash is consistent with this.
+    std::hash <variant> hash;
+    BOOST_CHECK (hash (variant (5)) != hash (variant (5u)));
+
+    std::unordered_set <variant, std::hash <variant>, rime::variant_equal_to>
+        set;
+    set.insert (variant (5));
+    set.insert (variant (5u));
+    set.insert (variant (std::string ("five")));
+    set.insert (variant (5));
+    set.insert (variant());
+    BOOST_CHECK_EQUAL (set.size(), 4u);
+    BOOST_CHECK (set.count (variant (std::string ("five"))) == 1);
+    BOOST_CHECK (set.count (variant (6)) == 0);
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_hash_range) {
+    std::vector <variant> variants;
+    variants.push_back (variant (1));
+    variants.push_back (variant (std::string ("a")));
+    variants.push_back (variant (2u));
+    variants.push_back (variant());
+    variants.push_back (variant (3));
+    variants.push_back (variant (std::string ("b")));
+    variants.push_back (variant (1));
+    // Runs of the same type.
+    variants.push_back (variant (4));
+    variants.push_back (variant (5));
+    variants.push_back (variant());
+    variants.push_back (variant());
+    variants.push_back (variant (std::string ("c")));
+
+    std::vector <std::size_t> hashes (variants.size());
+    rime::hash_range (variants.begin(), variants.end(), hashes.begin());
+
+    std::vector <std::size_t> expected;
+    for (variant const & v : variants)
+        expected.push_back (std::hash <variant>() (v));
+    BOOST_CHECK_EQUAL_COLLECTIONS (hashes.begin(), hashes.end(),
+        expected.begin(), expected.end());
+
+    std::vector <std::size_t> sequential_hashes (variants.size());
+    rime::hash_range <rime::visit_order::sequential> (
+        variants.begin(), variants.end(), sequential_hashes.begin());
+    BOOST_CHECK_EQUAL_COLLECTIONS (
+        sequential_hashes.begin(), sequential_hashes.end(),
+        expected.begin(), expected.end());
+
+    // Empty range.
+    rime::hash_range (variants.begin(), variants.begin(), hashes.begin());
+    rime::hash_range <rime::visit_order::sequential> (
+        variants.begin(), variants.begin(), hashes.begin());
+    BOOST_CHECK_EQUAL_COLLECTIONS (hashes.begin(), hashes.end(),
+        expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,180 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Test rime::packed_variant_sequence.
+*/
+
+#define BOOST_TEST_MODULE test_rime_packed_variant_sequence
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/packed_variant_sequence.hpp"
+
+#include <string>
+#include <vector>
+#include <type_traits>
+
+#include <boost/mpl/assert.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_rime_packed_variant_sequence)
+
+struct large {
+    double values [32];
+    explicit large (double value) { values [0] = value; }
+};
+
+struct describe {
+    std::string operator() (char c) const
+    { return std::string ("char ") + c; }
+    std::string operator() (int i) const
+    { return "int " + std::to_string (i); }
+    std::string operator() (std::string const & s) const
+    { return "string " + s; }
+    std::string operator() (large const & l) const
+    { return "large " + std::to_string (int (l.values [0])); }
+    std::string operator() () const { return "void"; }
+};
+
+struct collect {
+    std::vector <std::string> & descriptions;
+    explicit collect (std::vector <std::string> & descriptions)
+    : descriptions (descriptions) {}
+
+    template <class ... Arguments> void operator() (Arguments && ... arguments)
+        const
+    { descriptions.push_back (describe() (arguments ...)); }
+};
+
+struct append_exclamation {
+    void operator() (std::string & s) const { s += "!"; }
+    template <class Type> void operator() (Type &) const {}
+    void operator() () const {}
+};
+
+BOOST_AUTO_TEST_CASE (test_rime_packed_variant_sequence_basic) {
+    typedef rime::packed_variant_sequence <char, int, large> sequence;
+    BOOST_MPL_ASSERT ((std::is_same <sequence::reference,
+        rime::variant_ref <char, int, large>>));
+    BOOST_MPL_ASSERT ((std::is_same <sequence::const_reference,
+        rime::variant_ref <char const, int const, large const>>));
+
+    sequence s (1024);
+    BOOST_CHECK (s.empty());
+    BOOST_CHECK (s.begin() == s.end());
+
+    s.append ('a');
+    s.append (5);
+    s.append (large (7));
+    s.emplace_back <char> ('b');
+    s.append (rime::variant <int, char> (9));
+    BOOST_CHECK_EQUAL (s.size(), 5u);
+
+    // Each char takes two bytes at most; the int eight; the large more.
+    BOOST_CHECK (s.bytes_used() < 2 * sizeof (large));
+    BOOST_CHECK (s.bytes_used() >= sizeof (large) + 2 + 4 + 2 + 4);
+
+    sequence::iterator i = s.begin();
+    BOOST_CHECK_EQUAL (rime::get <char &> (*i), 'a');
+    ++ i;
+    BOOST_CHECK_EQUAL (rime::get <int &> (*i), 5);
+    rime::get <int &> (*i) = 6;
+    ++ i;
+    BOOST_CHECK_EQUAL (rime::get <large &> (*i).values [0], 7.);
+    ++ i;
+    BOOST_CHECK (i != s.end());
+    BOOST_CHECK_EQUAL (rime::visit (describe()) (*i), "char b");
+    i ++;
+    BOOST_CHECK_EQUAL (rime::visit (describe()) (*i), "int 9");
+    ++ i;
+    BOOST_CHECK (i == s.end());
+
+    std::vector <std::string> descriptions;
+    s.visit_each (collect (descriptions));
+    std::vector <std::string> expected {
+        "char a", "int 6", "large 7", "char b", "int 9" };
+    BOOST_CHECK_EQUAL_COLLECTIONS (descriptions.begin(), descriptions.end(),
+        expected.begin(), expected.end());
+
+    // Const iteration.
+    sequence const & c = s;
+    descriptions.clear();
+    for (sequence::const_reference element : c)
+        descriptions.push_back (rime::visit (describe()) (element));
+    BOOST_CHECK_EQUAL_COLLECTIONS (descriptions.begin(), descriptions.end(),
+        expected.begin(), expected.end());
+
+    sequence::const_iterator ci = s.begin();
+    BOOST_CHECK (ci == s.begin());
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_packed_variant_sequence_blocks) {
+    typedef rime::packed_variant_sequence <int, large> sequence;
+    sequence s (64);
+    // Larger than a block.
+    s.append (large (1));
+    for (int i = 0; i != 100; ++ i)
+        s.append (i);
+    s.append (large (2));
+    BOOST_CHECK_EQUAL (s.size(), 102u);
+
+    int total = 0;
+    int count = 0;
+    for (sequence::reference element : s) {
+        if (element.contains <int &>())
+            total += rime::get <int &> (element);
+        ++ count;
+    }
+    BOOST_CHECK_EQUAL (count, 102);
+    BOOST_CHECK_EQUAL (total, 4950);
+
+    sequence copy (s);
+    BOOST_CHECK_EQUAL (copy.size(), 102u);
+    BOOST_CHECK_EQUAL (copy.bytes_used(), s.bytes_used());
+
+    sequence moved (std::move (copy));
+    BOOST_CHECK_EQUAL (moved.size(), 102u);
+    BOOST_CHECK (copy.empty());
+
+    moved.clear();
+    BOOST_CHECK (moved.empty());
+    BOOST_CHECK (moved.begin() == moved.end());
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_packed_variant_sequence_nontrivial) {
+    typedef rime::packed_variant_sequence <void, std::string, int> sequence;
+    sequence s;
+    s.append (std::string ("hello"));
+    s.emplace_back <void>();
+    s.emplace_back <std::string> (3, 'x');
+    s.append (rime::variant <void, int> ());
+    s.append (4);
+
+    s.visit_each (append_exclamation());
+
+    sequence copy (s);
+    std::vector <std::string> descriptions;
+    copy.visit_each (collect (descriptions));
+    std::vector <std::string> expected {
+        "string hello!", "void", "string xxx!", "void", "int 4" };
+    BOOST_CHECK_EQUAL_COLLECTIONS (descriptions.begin(), descriptions.end(),
+        expected.begin(), expected.end());
+
+    sequence::iterator second = ++ s.begin();
+    BOOST_CHECK ((*second).contains <void>());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
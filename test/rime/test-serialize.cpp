@@ -0,0 +1,159 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Test rime::serialize and rime::deserialize.
+*/
+
+#define BOOST_TEST_MODULE test_rime_serialize
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/serialize.hpp"
+
+#include <cstdint>
+#include <string>
+#include <sstream>
+
+#include "rime/variant_ref.hpp"
+
+BOOST_AUTO_TEST_SUITE(test_rime_serialize)
+
+struct point {
+    double x;
+    double y;
+};
+
+BOOST_AUTO_TEST_SUITE_END()
+
+namespace rime {
+
+    /*
+    Write a string as its length and then its characters.
+    */
+    template <> struct serialization_codec <std::string> {
+        template <class Output>
+            static void write (Output & output, std::string const & s)
+        {
+            std::uint32_t size = std::uint32_t (s.size());
+            output.write (reinterpret_cast <char const *> (&size),
+                sizeof (size));
+            output.write (s.data(), s.size());
+        }
+
+        template <class Input> static std::string read (Input & input) {
+            std::uint32_t size;
+            read_bytes (input, reinterpret_cast <char *> (&size),
+                sizeof (size));
+            std::string result (size, ' ');
+            if (size != 0)
+                read_bytes (input, &result [0], size);
+            return result;
+        }
+    };
+
+} // namespace rime
+
+BOOST_AUTO_TEST_SUITE(test_rime_serialize)
+
+typedef rime::variant <void, char, int, point, std::string> variant;
+
+BOOST_AUTO_TEST_CASE (test_rime_serialize_round_trip) {
+    std::stringstream stream;
+    rime::serialize (stream, variant ('a'));
+    rime::serialize (stream, variant (17));
+    rime::serialize (stream, variant (point {1.5, 2.5}));
+    rime::serialize (stream, variant (std::string ("hello")));
+    rime::serialize (stream, variant());
+    rime::serialize (stream, variant (std::string()));
+
+    // The tag is one byte.
+    BOOST_CHECK_EQUAL (stream.str().size(),
+        (1 + 1) + (1 + 4) + (1 + 16) + (1 + 4 + 5) + 1 + (1 + 4));
+
+    variant v1 = rime::deserialize <variant> (stream);
+    BOOST_CHECK_EQUAL (rime::get <char> (v1), 'a');
+    variant v2 = rime::deserialize <variant> (stream);
+    BOOST_CHECK_EQUAL (rime::get <int> (v2), 17);
+    variant v3 = rime::deserialize <variant> (stream);
+    BOOST_CHECK_EQUAL (rime::get <point> (v3).x, 1.5);
+    BOOST_CHECK_EQUAL (rime::get <point> (v3).y, 2.5);
+    variant v4 = rime::deserialize <variant> (stream);
+    BOOST_CHECK_EQUAL (rime::get <std::string> (v4), "hello");
+    variant v5 = rime::deserialize <variant> (stream);
+    BOOST_CHECK (v5.contains <void>());
+    variant v6 = rime::deserialize <variant> (stream);
+    BOOST_CHECK_EQUAL (rime::get <std::string> (v6), "");
+
+    // Nothing left.
+    BOOST_CHECK_THROW (rime::deserialize <variant> (stream),
+        rime::serialization_error);
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_serialize_references) {
+    // A variant of references or a variant_ref writes the object.
+    std::stringstream stream;
+    int i = 5;
+    rime::serialize (stream, rime::variant <char &, int &> (i));
+    std::string s = "abc";
+    rime::serialize (stream, rime::variant_ref <char, std::string> (s));
+
+    auto v1 = rime::deserialize <rime::variant <char, int>> (stream);
+    BOOST_CHECK_EQUAL (rime::get <int> (v1), 5);
+    auto v2 = rime::deserialize <rime::variant <char, std::string>> (stream);
+    BOOST_CHECK_EQUAL (rime::get <std::string> (v2), "abc");
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_serialize_bool) {
+    typedef rime::variant <bool, int> bool_variant;
+    std::stringstream stream;
+    rime::serialize (stream, bool_variant (true));
+    rime::serialize (stream, bool_variant (false));
+    BOOST_CHECK_EQUAL (stream.str().size(), 4u);
+
+    bool_variant v1 = rime::deserialize <bool_variant> (stream);
+    BOOST_CHECK_EQUAL (rime::get <bool> (v1), true);
+    bool_variant v2 = rime::deserialize <bool_variant> (stream);
+    BOOST_CHECK_EQUAL (rime::get <bool> (v2), false);
+
+    // Only 0 and 1 are valid.
+    std::stringstream invalid;
+    invalid.put (0);
+    invalid.put (2);
+    BOOST_CHECK_THROW (rime::deserialize <bool_variant> (invalid),
+        rime::serialization_error);
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_serialize_errors) {
+    {
+        // Invalid tag.
+        std::stringstream stream;
+        stream.put (5);
+        BOOST_CHECK_THROW (rime::deserialize <variant> (stream),
+            rime::serialization_error);
+    }
+    {
+        // Truncated object.
+        std::stringstream stream;
+        rime::serialize (stream, variant (point {1, 2}));
+        std::string data = stream.str();
+        std::stringstream truncated (data.substr (0, data.size() - 1));
+        BOOST_CHECK_THROW (rime::deserialize <variant> (truncated),
+            rime::serialization_error);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -36,6 +36,7 @@ limitations under the License.
 
 #include <iostream>
 #include <array>
+#include <vector>
 
 struct convertee {};
 struct converted {
@@ -1137,4 +1138,224 @@ BOOST_AUTO_TEST_CASE (test_rime_variant_objects) {
     }
 }
 
+template <std::size_t Index> struct empty_type {};
+
+// The index of the contained type should take up as little space as possible.
+BOOST_AUTO_TEST_CASE (test_rime_variant_size) {
+    BOOST_CHECK_EQUAL (sizeof (rime::variant <char, bool>), 2u);
+    BOOST_CHECK_EQUAL (sizeof (rime::variant <char, void>), 2u);
+    BOOST_CHECK_EQUAL (sizeof (rime::variant <char, bool, void>), 2u);
+    BOOST_CHECK_EQUAL (
+        sizeof (rime::variant <short, char>), 2 * sizeof (short));
+    BOOST_CHECK_EQUAL (sizeof (rime::variant <int, float>), 2 * sizeof (int));
+    BOOST_CHECK_EQUAL (sizeof (rime::variant <int, double>),
+        2 * alignof (double));
+
+    typedef rime::variant <
+        empty_type <0>, empty_type <1>, empty_type <2>, empty_type <3>,
+        empty_type <4>, empty_type <5>, empty_type <6>, empty_type <7>,
+        empty_type <8>, empty_type <9>, empty_type <10>, empty_type <11>,
+        empty_type <12>, empty_type <13>, empty_type <14>, empty_type <15>>
+        many_empty;
+    BOOST_CHECK_EQUAL (sizeof (many_empty), 2u);
+    many_empty v ((empty_type <15>()));
+    BOOST_CHECK_EQUAL (v.which(), 15u);
+
+    // which() still returns std::size_t.
+    BOOST_MPL_ASSERT ((std::is_same <
+        decltype (rime::variant <char, bool> ('a').which()), std::size_t>));
+}
+
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_trivial) {
+    // Variants of trivial types are trivially copyable and destructible.
+    static_assert (std::is_trivially_copyable <
+        rime::variant <int, double>>::value, "");
+    static_assert (std::is_trivially_destructible <
+        rime::variant <int, double>>::value, "");
+    static_assert (std::is_trivially_copyable <
+        rime::variant <char, void>>::value, "");
+    static_assert (std::is_trivially_copyable <
+        rime::variant <int &, float>>::value, "");
+
+    // Copying a variant <int, int const> const & changes int into int const,
+    // so it cannot be trivial.
+    static_assert (!std::is_trivially_copyable <
+        rime::variant <int, int const>>::value, "");
+    static_assert (std::is_trivially_destructible <
+        rime::variant <int, int const>>::value, "");
+    // Similarly, copying a variant <int, int const &> const & changes int into
+    // int const &.
+    static_assert (!std::is_trivially_copyable <
+        rime::variant <int, int const &>>::value, "");
+    static_assert (!std::is_trivially_copyable <
+        rime::variant <int const, int const &>>::value, "");
+
+    // Non-trivial types.
+    static_assert (!std::is_trivially_copyable <
+        rime::variant <int, std::string>>::value, "");
+    static_assert (!std::is_trivially_destructible <
+        rime::variant <int, std::string>>::value, "");
+
+    // Copying and moving trivial variants still works.
+    rime::variant <int, double> v (4.5);
+    rime::variant <int, double> copy (v);
+    BOOST_CHECK_EQUAL (copy.which(), 1u);
+    BOOST_CHECK_EQUAL (rime::get <double> (copy), 4.5);
+    rime::variant <int, double> moved (std::move (copy));
+    BOOST_CHECK_EQUAL (rime::get <double> (moved), 4.5);
+
+    rime::variant <int, int const> v2 (7);
+    rime::variant <int, int const> const & v2_const = v2;
+    rime::variant <int, int const> copy2 (v2_const);
+    BOOST_CHECK (copy2.contains <int const>());
+    BOOST_CHECK_EQUAL (rime::get <int const> (copy2), 7);
+
+    rime::variant <int, int const &> v3 (8);
+    BOOST_CHECK (v3.contains <int>());
+    rime::variant <int, int const &> copy3 (v3);
+    BOOST_CHECK (copy3.contains <int const &>());
+    BOOST_CHECK_EQUAL (&rime::get <int const &> (copy3), &rime::get <int> (v3));
+
+    rime::variant <int const, int const &> v4 (
+        rime::in_place_type <int const>(), 9);
+    rime::variant <int const, int const &> copy4 (v4);
+    BOOST_CHECK (copy4.contains <int const &>());
+    BOOST_CHECK_EQUAL (rime::get <int const &> (copy4), 9);
+
+    // The same conversion, when the variant is not trivially copyable and
+    // its trivial alternatives share one copying function.
+    typedef rime::variant <int, int const &, double, std::string> mixed;
+    mixed v5 (10);
+    mixed const & v5_const = v5;
+    mixed copy5 (v5_const);
+    BOOST_CHECK (copy5.contains <int const &>());
+    BOOST_CHECK_EQUAL (&rime::get <int const &> (copy5), &rime::get <int> (v5));
+    mixed v6 (2.5);
+    mixed copy6 (v6);
+    BOOST_CHECK_EQUAL (rime::get <double> (copy6), 2.5);
+}
+
+
+struct throwing_move {
+    throwing_move() {}
+    throwing_move (throwing_move const &) {}
+    throwing_move (throwing_move &&) noexcept (false) {}
+};
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_noexcept) {
+    typedef rime::variant <std::string, std::vector <char>> buffer;
+    static_assert (std::is_nothrow_move_constructible <buffer>::value, "");
+    static_assert (std::is_nothrow_destructible <buffer>::value, "");
+    static_assert (!std::is_nothrow_copy_constructible <buffer>::value, "");
+
+    static_assert (std::is_nothrow_move_constructible <
+        rime::variant <std::string, int &, void>>::value, "");
+
+    static_assert (!std::is_nothrow_move_constructible <
+        rime::variant <std::string, throwing_move>>::value, "");
+
+    // std::vector should move the elements when it reallocates, so the
+    // contained std::vector <char> should keep its memory.
+    std::vector <buffer> buffers;
+    buffers.push_back (buffer (std::vector <char> (100, 'a')));
+    char const * data = rime::get <std::vector <char>> (buffers.front()).data();
+    buffers.reserve (buffers.capacity() * 2 + 100);
+    BOOST_CHECK_EQUAL (
+        rime::get <std::vector <char>> (buffers.front()).data(), data);
+}
+
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_in_place) {
+    {
+        rime::variant <int, std::string> v (
+            rime::in_place_type <std::string>(), 3u, 'a');
+        BOOST_CHECK (v.contains <std::string>());
+        BOOST_CHECK_EQUAL (rime::get <std::string> (v), "aaa");
+    }
+    {
+        rime::variant <int, std::string> v (rime::in_place_index <0>(), 'a');
+        BOOST_CHECK (v.contains <int>());
+        BOOST_CHECK_EQUAL (rime::get <int> (v), int ('a'));
+    }
+    {
+        rime::variant <int, void> v ((rime::in_place_type <void>()));
+        BOOST_CHECK (v.contains <void>());
+    }
+    {
+        int i = 5;
+        rime::variant <int, int &> v (rime::in_place_type <int &>(), i);
+        BOOST_CHECK (v.contains <int &>());
+        BOOST_CHECK_EQUAL (&rime::get <int &> (v), &i);
+    }
+    // The object is constructed directly in the variant.
+    {
+        utility::tracked_registry r;
+        {
+            rime::variant <int, utility::tracked <int>> v (
+                rime::in_place_type <utility::tracked <int>>(), r, 8);
+            r.check_counts (1, 0, 0, 0, 0, 0, 0, 0);
+            BOOST_CHECK_EQUAL (
+                rime::get <utility::tracked <int>> (v).content(), 8);
+        }
+        r.check_counts (1, 0, 0, 0, 0, 0, 1, 0);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_convert_trivial) {
+    using rime::variant_detail::variant_base;
+
+    // These conversions copy the storage and look up the index in a table.
+    BOOST_MPL_ASSERT ((variant_base <int, float, std::string>
+        ::converts_by_copying_storage <rime::variant <int, float> &>));
+    BOOST_MPL_ASSERT ((variant_base <std::string, void, int, float>
+        ::converts_by_copying_storage <rime::variant <float, int, void> &&>));
+    BOOST_MPL_ASSERT ((variant_base <double, std::string, int &>
+        ::converts_by_copying_storage <rime::variant <int &, double> &>));
+    // These change the type, or contain a type that is not trivially
+    // copyable, so they do not.
+    BOOST_MPL_ASSERT_NOT ((variant_base <long, std::string>
+        ::converts_by_copying_storage <rime::variant <int, std::string> &>));
+    BOOST_MPL_ASSERT_NOT ((variant_base <double, std::string, int>
+        ::converts_by_copying_storage <rime::variant <int, std::string> &>));
+
+    {
+        rime::variant <int, float> v (3.5f);
+        rime::variant <int, float, std::string> widened (v);
+        BOOST_CHECK (widened.contains <float>());
+        BOOST_CHECK_EQUAL (rime::get <float> (widened), 3.5f);
+    }
+    {
+        rime::variant <float, int, void> v (7);
+        rime::variant <std::string, void, int, float> widened (std::move (v));
+        BOOST_CHECK (widened.contains <int>());
+        BOOST_CHECK_EQUAL (rime::get <int> (widened), 7);
+
+        rime::variant <float, int, void> v_void;
+        rime::variant <std::string, void, int, float> widened_void (v_void);
+        BOOST_CHECK (widened_void.contains <void>());
+    }
+    {
+        int i = 4;
+        rime::variant <int &, double> v (i);
+        rime::variant <double, std::string, int &> widened (v);
+        BOOST_CHECK (widened.contains <int &>());
+        BOOST_CHECK_EQUAL (&rime::get <int &> (widened), &i);
+    }
+    // These conversions change the type, so they cannot do this.
+    {
+        rime::variant <int, std::string> v (5);
+        rime::variant <long, std::string> converted (v);
+        BOOST_CHECK (converted.contains <long>());
+        BOOST_CHECK_EQUAL (rime::get <long> (converted), 5l);
+    }
+    {
+        rime::variant <int, std::string> v (std::string ("abc"));
+        rime::variant <double, std::string, int> widened (v);
+        BOOST_CHECK (widened.contains <std::string>());
+        BOOST_CHECK_EQUAL (rime::get <std::string> (widened), "abc");
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -454,6 +454,28 @@ BOOST_AUTO_TEST_CASE (test_variant_operator_binary) {
     check_binary_operators (long (-23), int (0));
 }
 
+// Comparisons between variants of the same type check first whether they
+// contain the same type.
+BOOST_AUTO_TEST_CASE (test_variant_operator_compare_same_variant) {
+    typedef rime::variant <int, double> variant;
+    variant const i5 (5);
+    variant i7 (7);
+    variant d5 (5.);
+
+    BOOST_MPL_ASSERT ((is_same <decltype (i5 == i7), bool>));
+
+    BOOST_CHECK (i5 == variant (5));
+    BOOST_CHECK (i5 < i7);
+    BOOST_CHECK (!(i7 <= i5));
+    BOOST_CHECK (d5 >= variant (5.));
+
+    // Different contained types.
+    BOOST_CHECK (i5 == d5);
+    BOOST_CHECK (d5 != i7);
+    BOOST_CHECK (d5 < i7);
+    BOOST_CHECK (!(i5 > d5));
+}
+
 BOOST_AUTO_TEST_CASE (test_variant_operator_subscript) {
     typedef rime::variant <std::array <int, 3>, short *> variant;
     typedef rime::variant <std::array <int, 3>, short *, long const *> variant2;
@@ -33,6 +33,21 @@ limitations under the License.
 
 #include "rime/variant.hpp"
 
+struct if_chain_tag {
+    if_chain_tag & operator += (int) { return *this; }
+};
+
+namespace rime {
+    // Use a different dispatch policy for one variant type.
+    template <> struct variant_dispatch_policy <variant <int, if_chain_tag>>
+    { typedef dispatch_policy::if_chain type; };
+
+    // Check for std::string and then double before using the normal policy.
+    template <> struct variant_hot_alternatives <
+        variant <int, double, std::string>>
+    { typedef meta::vector <std::string, double> type; };
+} // namespace rime
+
 BOOST_AUTO_TEST_SUITE(test_rime_variant_visit)
 
 struct plus {
@@ -307,6 +322,70 @@ BOOST_AUTO_TEST_CASE (test_rime_variant_call) {
     }
 }
 
+template <class Policy> void check_visit_policy() {
+    typedef rime::variant <int, float, double &> variant;
+    double d = 6.5;
+    variant vi (4);
+    variant vf (2.5f);
+    variant vd (d);
+    rime::variant <int, void> vv;
+
+    BOOST_CHECK_EQUAL (rime::get <int> (
+        rime::visit <Policy> (plus()) (vi, 1)), 5);
+    BOOST_CHECK_EQUAL (rime::get <float> (
+        rime::visit <Policy> (plus()) (vf, 1)), 3.5f);
+    BOOST_CHECK_EQUAL (rime::get <double> (
+        rime::visit <Policy> (plus()) (vd, 1)), 7.5);
+    BOOST_CHECK_EQUAL (rime::visit <Policy> (count_arguments()) (vv, 4), 1);
+
+    auto result = rime::visit <Policy> (plus()) (vi, vf);
+    BOOST_CHECK_EQUAL (rime::get <float> (result), 6.5f);
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_visit_policy) {
+    check_visit_policy <rime::dispatch_policy::table>();
+    check_visit_policy <rime::dispatch_policy::switch_statement>();
+    check_visit_policy <rime::dispatch_policy::if_chain>();
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_dispatch_policy_trait) {
+    typedef rime::variant <int, if_chain_tag> variant;
+    variant v1 (5);
+    variant v2 (v1);
+    BOOST_CHECK_EQUAL (rime::get <int> (v2), 5);
+    variant v3 ((if_chain_tag()));
+    variant v4 (std::move (v3));
+    BOOST_CHECK (v4.contains <if_chain_tag>());
+    v1 += 3;
+    BOOST_CHECK_EQUAL (rime::get <int> (v1), 8);
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_hot_alternatives) {
+    typedef rime::variant <int, double, std::string> variant;
+    BOOST_MPL_ASSERT ((std::is_same <
+        rime::variant_dispatch_policy <variant>::type,
+        rime::dispatch_policy::hot_first <
+            rime::dispatch_policy::default_policy, 2, 1>>));
+
+    variant vi (5);
+    variant vd (2.5);
+    variant vs (std::string ("a"));
+
+    // which() is unchanged.
+    BOOST_CHECK_EQUAL (vi.which(), 0u);
+    BOOST_CHECK_EQUAL (vs.which(), 2u);
+
+    BOOST_CHECK_EQUAL (rime::get <int> (rime::visit (plus()) (vi)), 5);
+    BOOST_CHECK_EQUAL (rime::get <double> (rime::visit (plus()) (vd)), 2.5);
+    BOOST_CHECK_EQUAL (rime::get <std::string> (
+        rime::visit (plus()) (vs)), "a");
+
+    variant copy (vs);
+    BOOST_CHECK_EQUAL (rime::get <std::string> (copy), "a");
+    copy = vd;
+    BOOST_CHECK_EQUAL (rime::get <double> (copy), 2.5);
+}
+
 double take_two_arguments (int a, float b)
 { return double (a) + b; }
 
@@ -224,4 +224,62 @@ BOOST_AUTO_TEST_CASE (test_rime_variant_replace) {
     utility::check_all_throw_points (check_replace);
 }
 
+
+void check_emplace (utility::thrower & thrower) {
+    // int is replaced by int.
+    {
+        variant v1 (7);
+        v1.emplace <int> (9);
+        BOOST_CHECK (v1.contains <int>());
+        BOOST_CHECK_EQUAL (rime::get <int> (v1), 9);
+    }
+    // int is replaced by throwing, without any copy or move of the tracked
+    // object.
+    {
+        utility::tracked_registry r;
+        {
+            variant v1 (7);
+            try {
+                v1.emplace <throwing> (thrower, r, 10);
+            } catch (...) {
+                // The variant is left containing void.
+                BOOST_CHECK (v1.contains <void>());
+                throw;
+            }
+            BOOST_CHECK (v1.contains <throwing>());
+            BOOST_CHECK_EQUAL (
+                rime::get <throwing> (v1).content().content(), 10);
+        }
+    }
+    // throwing is replaced by throwing.
+    {
+        utility::tracked_registry r;
+        {
+            variant v1 (throwing (thrower, r, 17));
+            try {
+                v1.emplace <throwing> (thrower, r, 25);
+            } catch (...) {
+                BOOST_CHECK (v1.contains <void>());
+                throw;
+            }
+            BOOST_CHECK (v1.contains <throwing>());
+            BOOST_CHECK_EQUAL (
+                rime::get <throwing> (v1).content().content(), 25);
+        }
+    }
+    // throwing is replaced by void.
+    {
+        utility::tracked_registry r;
+        {
+            variant v1 (throwing (thrower, r, 17));
+            v1.emplace <void>();
+            BOOST_CHECK (v1.contains <void>());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_emplace) {
+    utility::check_all_throw_points (check_emplace);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,122 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#define BOOST_TEST_MODULE test_rime_variant_visit_range
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/visit_range.hpp"
+
+#include <string>
+#include <vector>
+#include <list>
+
+BOOST_AUTO_TEST_SUITE(test_rime_variant_visit_range)
+
+typedef rime::variant <int, std::string, void> variant;
+
+/**
+Record the calls as strings.
+*/
+struct record {
+    std::vector <std::string> & calls;
+
+    explicit record (std::vector <std::string> & calls) : calls (calls) {}
+
+    void operator() (int i) const { calls.push_back (std::to_string (i)); }
+    void operator() (std::string const & s) const { calls.push_back (s); }
+    void operator() () const { calls.push_back ("void"); }
+};
+
+struct increment {
+    void operator() (int & i) const { ++ i; }
+    void operator() (std::string & s) const { s += "+"; }
+    void operator() () const {}
+};
+
+std::vector <variant> make_variants() {
+    std::vector <variant> variants;
+    variants.push_back (variant (1));
+    variants.push_back (variant (std::string ("a")));
+    variants.push_back (variant (2));
+    variants.push_back (variant());
+    variants.push_back (variant (3));
+    variants.push_back (variant (4));
+    variants.push_back (variant (std::string ("b")));
+    return variants;
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_visit_range_grouped) {
+    std::vector <variant> variants = make_variants();
+    std::vector <std::string> calls;
+    rime::visit_range (record (calls), variants.begin(), variants.end());
+
+    // The calls are grouped by type, and in order within each type.
+    std::vector <std::string> expected {
+        "1", "2", "3", "4", "a", "b", "void" };
+    BOOST_CHECK_EQUAL_COLLECTIONS (calls.begin(), calls.end(),
+        expected.begin(), expected.end());
+
+    calls.clear();
+    rime::visit_range <rime::visit_order::grouped> (
+        record (calls), variants.begin(), variants.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS (calls.begin(), calls.end(),
+        expected.begin(), expected.end());
+
+    // Empty range.
+    calls.clear();
+    rime::visit_range (record (calls), variants.begin(), variants.begin());
+    BOOST_CHECK (calls.empty());
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_visit_range_sequential) {
+    std::vector <variant> variants = make_variants();
+    std::vector <std::string> calls;
+    rime::visit_range <rime::visit_order::sequential> (
+        record (calls), variants.begin(), variants.end());
+
+    // The calls are in the order of the elements.
+    std::vector <std::string> expected {
+        "1", "a", "2", "void", "3", "4", "b" };
+    BOOST_CHECK_EQUAL_COLLECTIONS (calls.begin(), calls.end(),
+        expected.begin(), expected.end());
+
+    // Empty range.
+    calls.clear();
+    rime::visit_range <rime::visit_order::sequential> (
+        record (calls), variants.begin(), variants.begin());
+    BOOST_CHECK (calls.empty());
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_visit_range_mutable) {
+    // Forward iterators that are not random-access.
+    std::vector <variant> vector_variants = make_variants();
+    std::list <variant> variants (
+        vector_variants.begin(), vector_variants.end());
+
+    rime::visit_range (increment(), variants.begin(), variants.end());
+    rime::visit_range <rime::visit_order::sequential> (
+        increment(), variants.begin(), variants.end());
+
+    std::vector <std::string> calls;
+    rime::visit_range <rime::visit_order::sequential> (
+        record (calls), variants.cbegin(), variants.cend());
+    std::vector <std::string> expected {
+        "3", "a++", "4", "void", "5", "6", "b++" };
+    BOOST_CHECK_EQUAL_COLLECTIONS (calls.begin(), calls.end(),
+        expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,129 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Test variants that store the index of the type in the pointer.
+*/
+
+#define BOOST_TEST_MODULE test_rime_variant_tag_in_pointer
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/variant.hpp"
+
+#include <string>
+#include <type_traits>
+
+#include <boost/mpl/assert.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_rime_variant_tag_in_pointer)
+
+// The types are incomplete where the variant types are declared.
+struct leaf;
+struct branch;
+
+typedef rime::variant <leaf &, branch &> node;
+typedef rime::variant <leaf const &, branch const &, void> const_node;
+// The same types in a different order, with the normal layout.
+typedef rime::variant <branch &, leaf &> normal_node;
+
+BOOST_AUTO_TEST_SUITE_END()
+
+namespace rime {
+    template <> struct variant_tag_in_pointer <
+        ::test_rime_variant_tag_in_pointer::node>
+    : boost::mpl::true_ {};
+    template <> struct variant_tag_in_pointer <
+        ::test_rime_variant_tag_in_pointer::const_node>
+    : boost::mpl::true_ {};
+} // namespace rime
+
+BOOST_AUTO_TEST_SUITE(test_rime_variant_tag_in_pointer)
+
+struct leaf { int value; };
+struct branch { leaf * left; leaf * right; };
+
+struct describe {
+    std::string operator() (leaf const & l) const
+    { return "leaf " + std::to_string (l.value); }
+    std::string operator() (branch const &) const { return "branch"; }
+    std::string operator() () const { return "none"; }
+};
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_tag_in_pointer_layout) {
+    static_assert (sizeof (node) == sizeof (void *),
+        "The index should be stored in the pointer.");
+    static_assert (sizeof (const_node) == sizeof (void *),
+        "The index should be stored in the pointer.");
+    static_assert (sizeof (normal_node) > sizeof (void *),
+        "The index should be stored separately by default.");
+
+    BOOST_MPL_ASSERT ((std::is_trivially_copyable <node>));
+    BOOST_MPL_ASSERT ((std::is_trivially_destructible <node>));
+    BOOST_MPL_ASSERT ((std::is_trivially_copyable <const_node>));
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_tag_in_pointer_use) {
+    leaf l = { 5 };
+    branch b = { &l, &l };
+
+    node n1 (l);
+    BOOST_CHECK_EQUAL (n1.which(), 0u);
+    BOOST_CHECK (n1.contains <leaf &>());
+    BOOST_CHECK_EQUAL (&rime::get <leaf &> (n1), &l);
+    BOOST_CHECK_THROW (rime::get <branch &> (n1), rime::bad_get);
+    BOOST_CHECK (rime::get <branch &> (&n1) == nullptr);
+
+    node n2 (b);
+    BOOST_CHECK_EQUAL (n2.which(), 1u);
+    BOOST_CHECK_EQUAL (&rime::get <branch &> (n2), &b);
+    BOOST_CHECK_EQUAL (rime::get <branch &> (n2).right->value, 5);
+
+    // Copy.
+    node n3 (n2);
+    BOOST_CHECK_EQUAL (n3.which(), 1u);
+    BOOST_CHECK_EQUAL (&rime::get <branch &> (n3), &b);
+
+    BOOST_CHECK_EQUAL (rime::visit (describe()) (n1), "leaf 5");
+    BOOST_CHECK_EQUAL (rime::visit (describe()) (n2), "branch");
+
+    // Modify through the reference.
+    rime::get <leaf &> (n1).value = 7;
+    BOOST_CHECK_EQUAL (l.value, 7);
+
+    leaf const & const_l = l;
+    const_node c1 (const_l);
+    BOOST_CHECK_EQUAL (c1.which(), 0u);
+    BOOST_CHECK_EQUAL (&rime::get <leaf const &> (c1), &l);
+
+    const_node c2 ((rime::in_place_type <void>()));
+    BOOST_CHECK (c2.contains <void>());
+    BOOST_CHECK_EQUAL (rime::visit (describe()) (c2), "none");
+    c2.emplace <branch const &> (b);
+    BOOST_CHECK_EQUAL (&rime::get <branch const &> (c2), &b);
+    c2.replace (c1);
+    BOOST_CHECK_EQUAL (&rime::get <leaf const &> (c2), &l);
+
+    // Convert to and from the normal layout.
+    normal_node normal (n2);
+    BOOST_CHECK_EQUAL (normal.which(), 0u);
+    BOOST_CHECK_EQUAL (&rime::get <branch &> (normal), &b);
+    node n4 (normal);
+    BOOST_CHECK_EQUAL (n4.which(), 1u);
+    BOOST_CHECK_EQUAL (&rime::get <branch &> (n4), &b);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,249 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Test rime::boxed and variants that store large alternatives on the heap.
+*/
+
+#define BOOST_TEST_MODULE test_rime_variant_boxed
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/variant.hpp"
+#include "rime/boxed.hpp"
+#include "rime/storage_policy.hpp"
+
+#include <string>
+#include <vector>
+#include <type_traits>
+
+#include <boost/mpl/assert.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_rime_variant_boxed)
+
+int allocation_num = 0;
+
+/**
+Allocator that counts the number of objects that are currently allocated.
+*/
+template <class Type> struct counting_allocator {
+    typedef Type value_type;
+
+    counting_allocator() {}
+    template <class Other>
+        counting_allocator (counting_allocator <Other> const &) {}
+
+    Type * allocate (std::size_t size) {
+        ++ allocation_num;
+        return std::allocator <Type>().allocate (size);
+    }
+    void deallocate (Type * pointer, std::size_t size) {
+        -- allocation_num;
+        std::allocator <Type>().deallocate (pointer, size);
+    }
+
+    bool operator== (counting_allocator const &) const { return true; }
+    bool operator!= (counting_allocator const &) const { return false; }
+};
+
+struct buffer {
+    char data [256];
+    int size;
+
+    explicit buffer (int size) : size (size) {}
+};
+
+typedef rime::variant <int, buffer> small_variant;
+typedef rime::variant <int, buffer, std::string> small_variant_2;
+
+BOOST_AUTO_TEST_SUITE_END()
+
+namespace rime {
+    template <> struct variant_storage_policy <
+        ::test_rime_variant_boxed::small_variant>
+    {
+        typedef storage_policy::box_larger_than <16,
+            ::test_rime_variant_boxed::counting_allocator <void>> type;
+    };
+    template <> struct variant_storage_policy <
+        ::test_rime_variant_boxed::small_variant_2>
+    {
+        typedef storage_policy::box_larger_than <64,
+            ::test_rime_variant_boxed::counting_allocator <void>> type;
+    };
+} // namespace rime
+
+BOOST_AUTO_TEST_SUITE(test_rime_variant_boxed)
+
+BOOST_AUTO_TEST_CASE (test_rime_boxed) {
+    typedef rime::boxed <std::string, counting_allocator <std::string>> box;
+    BOOST_MPL_ASSERT ((rime::is_boxed <box>));
+    BOOST_MPL_ASSERT_NOT ((rime::is_boxed <std::string>));
+    BOOST_MPL_ASSERT ((std::is_nothrow_move_constructible <box>));
+    static_assert (sizeof (box) == sizeof (std::string *),
+        "An empty allocator should take no space.");
+
+    {
+        box b1 (std::string ("abc"));
+        BOOST_CHECK_EQUAL (allocation_num, 1);
+        BOOST_CHECK_EQUAL (b1.get(), "abc");
+
+        box b2 (std::allocator_arg, counting_allocator <std::string>(),
+            3, 'd');
+        BOOST_CHECK_EQUAL (allocation_num, 2);
+        BOOST_CHECK_EQUAL (b2.get(), "ddd");
+
+        box b3 (b1);
+        BOOST_CHECK_EQUAL (allocation_num, 3);
+        BOOST_CHECK (&b3.get() != &b1.get());
+        b3.get() += "e";
+        BOOST_CHECK_EQUAL (b1.get(), "abc");
+        BOOST_CHECK_EQUAL (b3.get(), "abce");
+
+        std::string const * object = &b3.get();
+        box b4 (std::move (b3));
+        BOOST_CHECK_EQUAL (allocation_num, 3);
+        BOOST_CHECK_EQUAL (&b4.get(), object);
+
+        // Assignment assigns the object in place.
+        b4 = b2;
+        BOOST_CHECK_EQUAL (allocation_num, 3);
+        BOOST_CHECK_EQUAL (&b4.get(), object);
+        BOOST_CHECK_EQUAL (b4.get(), "ddd");
+        b4 = b4;
+        BOOST_CHECK_EQUAL (b4.get(), "ddd");
+
+        // Assigning to a moved-from box allocates a new object.
+        b3 = b1;
+        BOOST_CHECK_EQUAL (allocation_num, 4);
+        BOOST_CHECK_EQUAL (b3.get(), "abc");
+        BOOST_CHECK (&b3.get() != &b1.get());
+    }
+    BOOST_CHECK_EQUAL (allocation_num, 0);
+}
+
+/*
+A variant with a boxed alternative that is visible to the user.
+Assigning a variant assigns the contained objects, so it only compiles if
+boxed is assignable.
+*/
+BOOST_AUTO_TEST_CASE (test_rime_boxed_in_variant) {
+    typedef rime::boxed <std::string, counting_allocator <std::string>> box;
+    {
+        rime::variant <box> v1 (box (std::string ("abc")));
+        rime::variant <box> v2 (box (std::string ("def")));
+        BOOST_CHECK_EQUAL (allocation_num, 2);
+
+        v2 = v1;
+        BOOST_CHECK_EQUAL (allocation_num, 2);
+        BOOST_CHECK_EQUAL (rime::get <box> (v2).get(), "abc");
+        BOOST_CHECK (&rime::get <box> (v2).get()
+            != &rime::get <box> (v1).get());
+
+        rime::variant <int, box> v3 (box (std::string ("ghi")));
+        BOOST_CHECK_EQUAL (allocation_num, 3);
+        rime::get <box> (v3) = rime::get <box> (v1);
+        BOOST_CHECK_EQUAL (allocation_num, 3);
+        BOOST_CHECK_EQUAL (rime::get <box> (v3).get(), "abc");
+    }
+    BOOST_CHECK_EQUAL (allocation_num, 0);
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_boxed_layout) {
+    static_assert (sizeof (small_variant) <= 2 * sizeof (void *),
+        "buffer should be stored on the heap.");
+    static_assert (sizeof (small_variant_2) <= sizeof (std::string) + 8,
+        "buffer should be stored on the heap.");
+
+    // Moving allocates a new box.
+    BOOST_MPL_ASSERT_NOT ((
+        std::is_nothrow_move_constructible <small_variant>));
+    BOOST_MPL_ASSERT_NOT ((std::is_trivially_copyable <small_variant>));
+    BOOST_MPL_ASSERT_NOT ((std::is_trivially_destructible <small_variant>));
+}
+
+struct get_size {
+    int operator() (int i) const { return i; }
+    int operator() (buffer const & b) const { return b.size; }
+};
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_boxed_use) {
+    {
+        small_variant v1 (5);
+        BOOST_CHECK_EQUAL (allocation_num, 0);
+        BOOST_CHECK_EQUAL (rime::get <int> (v1), 5);
+
+        // The converting constructor sees through the box.
+        small_variant v2 (buffer (7));
+        BOOST_CHECK_EQUAL (allocation_num, 1);
+        BOOST_CHECK (v2.contains <buffer>());
+        BOOST_CHECK_EQUAL (rime::get <buffer> (v2).size, 7);
+        BOOST_CHECK (rime::get <buffer> (&v1) == nullptr);
+
+        rime::get <buffer> (v2).size = 8;
+        BOOST_CHECK_EQUAL (rime::get <buffer> (v2).size, 8);
+
+        // visit sees through the box.
+        BOOST_CHECK_EQUAL (rime::visit (get_size()) (v2), 8);
+        BOOST_CHECK_EQUAL (rime::visit (get_size()) (v1), 5);
+
+        // Copy.
+        small_variant v3 (v2);
+        BOOST_CHECK_EQUAL (allocation_num, 2);
+        BOOST_CHECK_EQUAL (rime::get <buffer> (v3).size, 8);
+        BOOST_CHECK (&rime::get <buffer> (v3) != &rime::get <buffer> (v2));
+
+        // Move: this moves the object into a new box.
+        buffer const * object = &rime::get <buffer> (v3);
+        small_variant v4 (std::move (v3));
+        BOOST_CHECK_EQUAL (allocation_num, 3);
+        BOOST_CHECK (&rime::get <buffer> (v4) != object);
+        BOOST_CHECK_EQUAL (rime::get <buffer> (v4).size, 8);
+
+        // The moved-from variant still holds a valid object.
+        BOOST_CHECK (v3.contains <buffer>());
+        BOOST_CHECK_EQUAL (&rime::get <buffer> (v3), object);
+        rime::get <buffer> (v3) = buffer (4);
+        BOOST_CHECK_EQUAL (allocation_num, 3);
+        BOOST_CHECK_EQUAL (rime::get <buffer> (v3).size, 4);
+        BOOST_CHECK_EQUAL (rime::visit (get_size()) (v3), 4);
+        {
+            small_variant v3_copy (v3);
+            BOOST_CHECK_EQUAL (allocation_num, 4);
+            BOOST_CHECK_EQUAL (rime::get <buffer> (v3_copy).size, 4);
+        }
+        BOOST_CHECK_EQUAL (allocation_num, 3);
+
+        // In-place construction and emplace.
+        small_variant v5 (rime::in_place_type <buffer>(), 9);
+        BOOST_CHECK_EQUAL (allocation_num, 4);
+        BOOST_CHECK_EQUAL (rime::get <buffer> (v5).size, 9);
+        v5.emplace <int> (10);
+        BOOST_CHECK_EQUAL (allocation_num, 3);
+        BOOST_CHECK_EQUAL (rime::get <int> (v5), 10);
+
+        // Conversion to and from a variant with a different storage policy.
+        rime::variant <buffer, int> unboxed (v4);
+        BOOST_CHECK_EQUAL (allocation_num, 3);
+        BOOST_CHECK_EQUAL (rime::get <buffer> (unboxed).size, 8);
+        small_variant_2 v6 (unboxed);
+        BOOST_CHECK_EQUAL (allocation_num, 4);
+        BOOST_CHECK_EQUAL (rime::get <buffer> (v6).size, 8);
+    }
+    BOOST_CHECK_EQUAL (allocation_num, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
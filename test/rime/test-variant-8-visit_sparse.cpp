@@ -0,0 +1,132 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Test rime::visit_sparse.
+*/
+
+#define BOOST_TEST_MODULE test_rime_variant_visit_sparse
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/visit_sparse.hpp"
+
+#include <string>
+#include <type_traits>
+
+#include <boost/mpl/assert.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_rime_variant_visit_sparse)
+
+typedef rime::variant <int, double, std::string> variant;
+
+/**
+Describe the types it is called with.
+Only int and double can be added, so calling this with a std::string and a
+number does not compile.
+*/
+struct add {
+    std::string operator() (int i, int j) const
+    { return "int " + std::to_string (i + j); }
+    std::string operator() (double d, double e) const
+    { return "double " + std::to_string (int (d + e)); }
+    std::string operator() (std::string const & s, std::string const & t)
+        const
+    { return s + t; }
+    std::string operator() (int i, int j, int k) const
+    { return "int " + std::to_string (i + j + k); }
+};
+
+struct fallback {
+    template <class ... Arguments>
+        std::string operator() (Arguments const & ...) const
+    { return "fallback"; }
+};
+
+BOOST_AUTO_TEST_CASE (test_rime_visit_sparse_two) {
+    typedef meta::vector <
+        meta::vector <int, int>,
+        meta::vector <double, double>,
+        meta::vector <std::string, std::string>> combinations;
+
+    variant i (3);
+    variant d (4.);
+    variant s (std::string ("a"));
+
+    auto visitor = rime::visit_sparse <combinations> (add(), fallback());
+    BOOST_MPL_ASSERT ((std::is_same <decltype (visitor (i, i)), std::string>));
+
+    BOOST_CHECK_EQUAL (visitor (i, i), "int 6");
+    BOOST_CHECK_EQUAL (visitor (d, d), "double 8");
+    BOOST_CHECK_EQUAL (visitor (s, s), "aa");
+    BOOST_CHECK_EQUAL (visitor (i, d), "fallback");
+    BOOST_CHECK_EQUAL (visitor (s, i), "fallback");
+    BOOST_CHECK_EQUAL (visitor (d, s), "fallback");
+
+    // Non-variant arguments.
+    BOOST_CHECK_EQUAL (visitor (i, 5), "int 8");
+    BOOST_CHECK_EQUAL (visitor (5., d), "double 9");
+    BOOST_CHECK_EQUAL (visitor (d, 5), "fallback");
+
+    // The policy can be given explicitly.
+    BOOST_CHECK_EQUAL ((rime::visit_sparse <combinations,
+        rime::dispatch_policy::table> (add(), fallback()) (d, d)),
+        "double 8");
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_visit_sparse_three) {
+    typedef meta::vector <meta::vector <int, int, int>> combinations;
+
+    variant i (3);
+    variant d (4.);
+    auto visitor = rime::visit_sparse <combinations> (add(), fallback());
+    BOOST_CHECK_EQUAL (visitor (i, i, i), "int 9");
+    BOOST_CHECK_EQUAL (visitor (i, i, d), "fallback");
+    BOOST_CHECK_EQUAL (visitor (d, i, i), "fallback");
+}
+
+struct count_void {
+    int operator() () const { return 0; }
+    int operator() (int) const { return 1; }
+};
+
+struct return_void {
+    template <class ... Arguments> void operator() (Arguments const & ...)
+        const {}
+};
+
+BOOST_AUTO_TEST_CASE (test_rime_visit_sparse_void) {
+    typedef rime::variant <void, int, double> variant;
+    typedef meta::vector <
+        meta::vector <void, void>, meta::vector <int, void>> combinations;
+
+    variant v;
+    variant i (5);
+    variant d (5.);
+
+    // void arguments are left out, as with visit.
+    auto visitor = rime::visit_sparse <combinations> (
+        count_void(), return_void());
+    typedef decltype (visitor (v, v)) result_type;
+    BOOST_MPL_ASSERT ((std::is_same <result_type, rime::variant <int, void>>));
+
+    BOOST_CHECK_EQUAL (rime::get <int> (visitor (v, v)), 0);
+    BOOST_CHECK_EQUAL (rime::get <int> (visitor (i, v)), 1);
+    BOOST_CHECK (visitor (v, i).contains <void>());
+    BOOST_CHECK (visitor (d, v).contains <void>());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
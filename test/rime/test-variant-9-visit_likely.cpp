@@ -0,0 +1,113 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Test rime::visit_likely.
+*/
+
+#define BOOST_TEST_MODULE test_rime_variant_visit_likely
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/visit_likely.hpp"
+
+#include <string>
+#include <type_traits>
+
+#include <boost/mpl/assert.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_rime_variant_visit_likely)
+
+typedef rime::variant <int, double, std::string> variant;
+
+struct describe {
+    std::string operator() (int i) const
+    { return "int " + std::to_string (i); }
+    std::string operator() (double d) const
+    { return "double " + std::to_string (int (d)); }
+    std::string operator() (std::string const & s) const
+    { return "string " + s; }
+};
+
+struct increment {
+    void operator() (int & i) const { ++ i; }
+    void operator() (double & d) const { d += 1; }
+    void operator() (std::string & s) const { s += "+"; }
+};
+
+struct return_type {
+    int operator() (int i) const { return i; }
+    double operator() (double d) const { return d; }
+    void operator() () const {}
+};
+
+BOOST_AUTO_TEST_CASE (test_rime_visit_likely_one) {
+    variant i (3);
+    variant d (4.);
+    variant s (std::string ("a"));
+
+    auto visitor = rime::visit_likely <int> (describe());
+    BOOST_MPL_ASSERT ((std::is_same <decltype (visitor (i)), std::string>));
+
+    BOOST_CHECK_EQUAL (visitor (i), "int 3");
+    BOOST_CHECK_EQUAL (visitor (d), "double 4");
+    BOOST_CHECK_EQUAL (visitor (s), "string a");
+
+    variant const & i_const = i;
+    BOOST_CHECK_EQUAL (visitor (i_const), "int 3");
+    BOOST_CHECK_EQUAL (visitor (variant (5)), "int 5");
+
+    // Modify the contents in place.
+    rime::visit_likely <std::string> (increment()) (i);
+    rime::visit_likely <std::string> (increment()) (s);
+    BOOST_CHECK_EQUAL (rime::get <int> (i), 4);
+    BOOST_CHECK_EQUAL (rime::get <std::string> (s), "a+");
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_visit_likely_more) {
+    variant i (3);
+    variant d (4.);
+    variant s (std::string ("a"));
+
+    auto visitor = rime::visit_likely <double, int> (describe());
+    BOOST_CHECK_EQUAL (visitor (i), "int 3");
+    BOOST_CHECK_EQUAL (visitor (d), "double 4");
+    BOOST_CHECK_EQUAL (visitor (s), "string a");
+
+    // No likely types: always visit.
+    BOOST_CHECK_EQUAL (rime::visit_likely<> (describe()) (d), "double 4");
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_visit_likely_result) {
+    typedef rime::variant <int, double, void> variant;
+    variant i (3);
+    variant d (4.5);
+    variant v;
+
+    // The result type is the same as with visit.
+    auto visitor = rime::visit_likely <int> (return_type());
+    typedef decltype (visitor (i)) result_type;
+    BOOST_MPL_ASSERT ((std::is_same <result_type,
+        decltype (rime::visit (return_type()) (i))>));
+
+    BOOST_CHECK_EQUAL (rime::get <int> (visitor (i)), 3);
+    BOOST_CHECK_EQUAL (rime::get <double> (visitor (d)), 4.5);
+    BOOST_CHECK (visitor (v).contains <void>());
+    BOOST_CHECK (rime::visit_likely <void> (return_type()) (v)
+        .contains <void>());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
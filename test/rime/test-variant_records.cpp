@@ -0,0 +1,276 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+\file
+Test writing variant records and reading them in place.
+*/
+
+#define BOOST_TEST_MODULE test_rime_variant_records
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/variant_records.hpp"
+#include "rime/mapped_variant_records.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <streambuf>
+#include <system_error>
+
+struct point {
+    double x;
+    double y;
+};
+
+// Over-aligned, so that the records start after padding.
+struct alignas (64) wide { char c; };
+
+namespace rime {
+    template <> struct variant_record_type_id <point>
+    : variant_record_type_id_base <point, 1000> {};
+
+    template <> struct variant_record_type_id <wide>
+    : variant_record_type_id_base <wide, 1001> {};
+} // namespace rime
+
+BOOST_AUTO_TEST_SUITE(test_rime_variant_records)
+
+static_assert (rime::variant_record_type_id <int>::value
+    != rime::variant_record_type_id <float>::value,
+    "Types with the same size must have different identifiers.");
+static_assert (rime::variant_record_type_id <int>::value
+    != rime::variant_record_type_id <unsigned>::value,
+    "Types with the same size must have different identifiers.");
+static_assert (rime::variant_record_type_id <long>::value
+    != rime::variant_record_type_id <double>::value,
+    "Types with the same size must have different identifiers.");
+
+struct describe {
+    std::string operator() (char c) const
+    { return std::string ("char ") + c; }
+    std::string operator() (int i) const
+    { return "int " + std::to_string (i); }
+    std::string operator() (point const & p) const {
+        return "point " + std::to_string (int (p.x)) + " "
+            + std::to_string (int (p.y));
+    }
+    std::string operator() () const { return "void"; }
+};
+
+struct collect {
+    std::vector <std::string> & descriptions;
+    explicit collect (std::vector <std::string> & descriptions)
+    : descriptions (descriptions) {}
+
+    template <class ... Arguments> void operator() (Arguments && ... arguments)
+        const
+    { descriptions.push_back (describe() (arguments ...)); }
+};
+
+typedef rime::variant_records_view <char, int, void, point> view;
+
+std::string write_records() {
+    std::ostringstream stream;
+    rime::variant_records_writer <char, int, void, point> writer (stream);
+    writer.append ('a');
+    writer.append (5);
+    writer.append_void();
+    writer.append (point {1, 2});
+    writer.append (rime::variant <int, char> ('b'));
+    int i = 7;
+    writer.append (rime::variant <int &, point> (i));
+    BOOST_CHECK_EQUAL (writer.size(), 6u);
+    writer.finish();
+    return stream.str();
+}
+
+/**
+Copy \a data into aligned memory.
+*/
+std::vector <std::uint64_t> aligned_copy (std::string const & data) {
+    std::vector <std::uint64_t> result ((data.size() + 7) / 8);
+    std::memcpy (result.data(), data.data(), data.size());
+    return result;
+}
+
+std::vector <std::string> const expected {
+    "char a", "int 5", "void", "point 1 2", "char b", "int 7" };
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_records_view) {
+    std::string data = write_records();
+    std::vector <std::uint64_t> memory = aligned_copy (data);
+
+    view records (memory.data(), data.size());
+    BOOST_CHECK_EQUAL (records.size(), 6u);
+    records.check_records();
+
+    std::vector <std::string> descriptions;
+    for (view::reference record : records)
+        descriptions.push_back (rime::visit (describe()) (record));
+    BOOST_CHECK_EQUAL_COLLECTIONS (descriptions.begin(), descriptions.end(),
+        expected.begin(), expected.end());
+
+    descriptions.clear();
+    records.visit_each (collect (descriptions));
+    BOOST_CHECK_EQUAL_COLLECTIONS (descriptions.begin(), descriptions.end(),
+        expected.begin(), expected.end());
+
+    // The records refer to the memory directly.
+    view::const_iterator i = records.begin();
+    ++ i;
+    int const & five = rime::get <int const &> (*i);
+    BOOST_CHECK_EQUAL (five, 5);
+    BOOST_CHECK (static_cast <void const *> (&five) > memory.data());
+    BOOST_CHECK (static_cast <void const *> (&five)
+        < memory.data() + memory.size());
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_records_errors) {
+    std::string data = write_records();
+    std::vector <std::uint64_t> memory = aligned_copy (data);
+
+    // Different types.
+    BOOST_CHECK_THROW ((rime::variant_records_view <char, int, point> (
+        memory.data(), data.size())), rime::variant_records_error);
+    BOOST_CHECK_THROW ((rime::variant_records_view <char, int, void, double> (
+        memory.data(), data.size())), rime::variant_records_error);
+    // Same sizes, different types.
+    BOOST_CHECK_THROW ((rime::variant_records_view <char, unsigned, void, point>
+        (memory.data(), data.size())), rime::variant_records_error);
+
+    // Truncated.
+    BOOST_CHECK_THROW (view (memory.data(), data.size() - 1),
+        rime::variant_records_error);
+    BOOST_CHECK_THROW (view (memory.data(), 10),
+        rime::variant_records_error);
+
+    // Only the header, but not the padding after it.
+    {
+        typedef rime::variant_records_format <wide> wide_format;
+        BOOST_CHECK (wide_format::data_offset()
+            > sizeof (rime::variant_records_header));
+        std::ostringstream stream;
+        rime::variant_records_writer <wide> writer (stream);
+        writer.append (wide {'w'});
+        writer.finish();
+        std::string wide_data = stream.str();
+        BOOST_CHECK (wide_data.size() <= 256);
+
+        alignas (64) char wide_memory [256];
+        std::memcpy (wide_memory, wide_data.data(), wide_data.size());
+        BOOST_CHECK_THROW ((rime::variant_records_view <wide> (wide_memory,
+            sizeof (rime::variant_records_header))),
+            rime::variant_records_error);
+        rime::variant_records_view <wide> records (
+            wide_memory, wide_data.size());
+        BOOST_CHECK_EQUAL (records.size(), 1u);
+    }
+
+    // Not finished.
+    std::ostringstream stream;
+    {
+        rime::variant_records_writer <char, int, void, point> writer (stream);
+        writer.append (5);
+    }
+    std::string unfinished = stream.str();
+    std::vector <std::uint64_t> unfinished_memory = aligned_copy (unfinished);
+    BOOST_CHECK_THROW (view (unfinished_memory.data(), unfinished.size()),
+        rime::variant_records_error);
+
+    // Corrupt tag.
+    view records (memory.data(), data.size());
+    char * first_tag = reinterpret_cast <char *> (memory.data())
+        + rime::variant_records_format <char, int, void, point>
+            ::data_offset();
+    *first_tag = 17;
+    BOOST_CHECK_THROW (records.check_records(), rime::variant_records_error);
+}
+
+/**
+Stream buffer with a fixed capacity, which cannot seek.
+*/
+template <std::size_t Capacity> struct fixed_buffer : std::streambuf {
+    char memory [Capacity];
+    fixed_buffer() { setp (memory, memory + Capacity); }
+};
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_records_write_errors) {
+    typedef rime::variant_records_writer <char, int, void, point> writer_type;
+
+    // The stream has already failed.
+    {
+        std::ostringstream stream;
+        stream.setstate (std::ios::badbit);
+        BOOST_CHECK_THROW (writer_type writer (stream),
+            rime::variant_records_error);
+    }
+    // The header does not fit.
+    {
+        fixed_buffer <8> buffer;
+        std::ostream stream (&buffer);
+        BOOST_CHECK_THROW (writer_type writer (stream),
+            rime::variant_records_error);
+    }
+    // A record does not fit.
+    {
+        fixed_buffer <256> buffer;
+        std::ostream stream (&buffer);
+        writer_type writer (stream);
+        point p = {1., 2.};
+        BOOST_CHECK_THROW (
+            for (int i = 0; i != 100; ++ i) writer.append (p),
+            rime::variant_records_error);
+    }
+    // The stream cannot seek back to the header.
+    {
+        fixed_buffer <4096> buffer;
+        std::ostream stream (&buffer);
+        writer_type writer (stream);
+        writer.append (5);
+        BOOST_CHECK_THROW (writer.finish(), rime::variant_records_error);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_records_mapped) {
+    std::string path = "test-variant_records.tmp";
+    {
+        std::string data = write_records();
+        std::ofstream file (path, std::ios::binary);
+        file.write (data.data(), data.size());
+    }
+    {
+        rime::mapped_variant_records <char, int, void, point> records (path);
+        BOOST_CHECK_EQUAL (records.size(), 6u);
+        std::vector <std::string> descriptions;
+        records.visit_each (collect (descriptions));
+        BOOST_CHECK_EQUAL_COLLECTIONS (
+            descriptions.begin(), descriptions.end(),
+            expected.begin(), expected.end());
+    }
+    std::remove (path.c_str());
+
+    BOOST_CHECK_THROW (
+        (rime::mapped_variant_records <char, int, void, point> (
+            "does-not-exist.tmp")),
+        std::system_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
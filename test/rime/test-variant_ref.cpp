@@ -0,0 +1,141 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#define BOOST_TEST_MODULE test_rime_variant_ref
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/variant_ref.hpp"
+
+#include <string>
+#include <type_traits>
+
+#include <boost/mpl/assert.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_rime_variant_ref)
+
+struct describe {
+    std::string operator() (int i) const { return "int " + std::to_string (i); }
+    std::string operator() (std::string const & s) const
+    { return "string " + s; }
+    std::string operator() () const { return "void"; }
+};
+
+struct append {
+    void operator() (int & i) const { i += 1; }
+    void operator() (std::string & s) const { s += "!"; }
+};
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_ref_traits) {
+    typedef rime::variant_ref <int, std::string const> ref;
+    BOOST_MPL_ASSERT ((rime::is_variant <ref>));
+    BOOST_MPL_ASSERT ((rime::is_variant_ref <ref const &>));
+    BOOST_MPL_ASSERT_NOT ((rime::is_variant_ref <rime::variant <int, float>>));
+    BOOST_MPL_ASSERT ((std::is_same <rime::variant_types <ref>::type,
+        meta::vector <int &, std::string const &>>));
+    BOOST_MPL_ASSERT ((std::is_trivially_copyable <ref>));
+    BOOST_CHECK (sizeof (ref) <= 2 * sizeof (void *));
+
+    // Only references to lvalues of the right types can be created.
+    BOOST_MPL_ASSERT ((std::is_constructible <ref, int &>));
+    BOOST_MPL_ASSERT ((std::is_constructible <ref, std::string &>));
+    BOOST_MPL_ASSERT ((std::is_constructible <ref, std::string const &>));
+    BOOST_MPL_ASSERT_NOT ((std::is_constructible <ref, int const &>));
+    BOOST_MPL_ASSERT_NOT ((std::is_constructible <ref, int>));
+    BOOST_MPL_ASSERT_NOT ((std::is_constructible <ref, long &>));
+
+    BOOST_MPL_ASSERT ((std::is_constructible <ref,
+        rime::variant <int, std::string> &>));
+    BOOST_MPL_ASSERT_NOT ((std::is_constructible <ref,
+        rime::variant <int, std::string> const &>));
+    BOOST_MPL_ASSERT_NOT ((std::is_constructible <ref,
+        rime::variant <std::string, int> &>));
+    BOOST_MPL_ASSERT ((std::is_constructible <
+        rime::variant_ref <int const, std::string const>,
+        rime::variant <int, std::string> const &>));
+    BOOST_MPL_ASSERT ((std::is_constructible <
+        rime::variant_ref <int const, std::string const>, ref>));
+    BOOST_MPL_ASSERT_NOT ((std::is_constructible <ref,
+        rime::variant_ref <int const, std::string const>>));
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_ref_use) {
+    int i = 5;
+    std::string s = "abc";
+
+    rime::variant_ref <int, std::string> r1 (i);
+    BOOST_CHECK_EQUAL (r1.which(), 0u);
+    BOOST_CHECK (r1.contains <int &>());
+    BOOST_CHECK (!r1.contains <std::string &>());
+    BOOST_CHECK_EQUAL (&rime::get <int &> (r1), &i);
+    BOOST_CHECK_THROW (rime::get <std::string &> (r1), rime::bad_get);
+    BOOST_CHECK (rime::get <std::string &> (&r1) == nullptr);
+
+    rime::variant_ref <int, std::string> r2 (s);
+    BOOST_CHECK_EQUAL (r2.which(), 1u);
+    BOOST_CHECK_EQUAL (&rime::get <std::string &> (r2), &s);
+
+    // visit.
+    BOOST_CHECK_EQUAL (rime::visit (describe()) (r1), "int 5");
+    BOOST_CHECK_EQUAL (rime::visit (describe()) (r2), "string abc");
+    rime::visit (append()) (r1);
+    rime::visit (append()) (r2);
+    BOOST_CHECK_EQUAL (i, 6);
+    BOOST_CHECK_EQUAL (s, "abc!");
+
+    // Operators.
+    {
+        double d = 1.5;
+        rime::variant_ref <int, double> number (i);
+        BOOST_CHECK_EQUAL (number + 1., 7.);
+        ++ number;
+        BOOST_CHECK_EQUAL (i, 7);
+        BOOST_CHECK (number == 7);
+
+        rime::variant_ref <int, double> number2 (d);
+        BOOST_CHECK_EQUAL (number + number2, 8.5);
+    }
+
+    // Refer to the contents of a variant.
+    rime::variant <int, std::string, void> v (std::string ("def"));
+    rime::variant_ref <int, std::string, void> r3 (v);
+    BOOST_CHECK_EQUAL (&rime::get <std::string &> (r3),
+        &rime::get <std::string> (v));
+    rime::get <std::string &> (r3) += "g";
+    BOOST_CHECK_EQUAL (rime::get <std::string> (v), "defg");
+
+    rime::variant <int, std::string, void> const & v_const = v;
+    rime::variant_ref <int const, std::string const, void> r4 (v_const);
+    BOOST_CHECK_EQUAL (rime::get <std::string const &> (r4), "defg");
+    rime::variant_ref <int const, std::string const, void> r5 (r3);
+    BOOST_CHECK_EQUAL (rime::get <std::string const &> (r5), "defg");
+
+    rime::variant <int, std::string, void> v_void;
+    rime::variant_ref <int, std::string, void> r6 (v_void);
+    BOOST_CHECK (r6.contains <void>());
+    BOOST_CHECK_EQUAL (rime::visit (describe()) (r6), "void");
+
+    // Copy the object that is referred to into a variant.
+    rime::variant <int, std::string, void> copy (r3);
+    BOOST_CHECK (copy.contains <std::string>());
+    BOOST_CHECK_EQUAL (rime::get <std::string> (copy), "defg");
+
+    // Convert into a variant of references.
+    rime::variant <int &, std::string &, void> references (r3);
+    BOOST_CHECK_EQUAL (&rime::get <std::string &> (references),
+        &rime::get <std::string> (v));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
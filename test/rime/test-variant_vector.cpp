@@ -0,0 +1,204 @@
+/*
+Copyright 2015 Rogier van Dalen.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#define BOOST_TEST_MODULE test_rime_variant_vector
+#include "utility/test/boost_unit_test.hpp"
+
+#include "rime/variant_vector.hpp"
+
+#include <string>
+#include <vector>
+#include <type_traits>
+
+#include <boost/mpl/assert.hpp>
+
+BOOST_AUTO_TEST_SUITE(test_rime_variant_vector)
+
+struct sum {
+    double & total;
+    int & string_count;
+
+    sum (double & total, int & string_count)
+    : total (total), string_count (string_count) {}
+
+    void operator() (int i) const { total += i; }
+    void operator() (double d) const { total += d; }
+    void operator() (std::string const &) const { ++ string_count; }
+};
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_vector) {
+    typedef rime::variant_vector <int, double, std::string, void> vector_type;
+
+    BOOST_MPL_ASSERT ((std::is_same <vector_type::reference,
+        rime::variant_ref <int, double, std::string, void>>));
+    BOOST_MPL_ASSERT ((std::is_same <vector_type::const_reference,
+        rime::variant_ref <int const, double const, std::string const,
+            void>>));
+
+    vector_type v;
+    BOOST_CHECK (v.empty());
+    BOOST_CHECK_EQUAL (v.size(), 0u);
+
+    v.push_back (5);
+    v.push_back (std::string ("abc"));
+    v.push_back (2.5);
+    // Same conversion as the constructor of variant.
+    v.push_back ("def");
+    v.push_back (7);
+    v.push_back (rime::variant <int, double, std::string, void>());
+    v.emplace_back <std::string> (3u, 'x');
+
+    BOOST_CHECK (!v.empty());
+    BOOST_CHECK_EQUAL (v.size(), 7u);
+
+    BOOST_CHECK_EQUAL (v.which (0), 0u);
+    BOOST_CHECK_EQUAL (v.which (1), 2u);
+    BOOST_CHECK_EQUAL (v.which (2), 1u);
+    BOOST_CHECK_EQUAL (v.which (3), 2u);
+    BOOST_CHECK_EQUAL (v.which (4), 0u);
+    BOOST_CHECK_EQUAL (v.which (5), 3u);
+    BOOST_CHECK_EQUAL (v.which (6), 2u);
+
+    BOOST_CHECK_EQUAL (rime::get <int &> (v [0]), 5);
+    BOOST_CHECK_EQUAL (rime::get <std::string &> (v [1]), "abc");
+    BOOST_CHECK_EQUAL (rime::get <double &> (v [2]), 2.5);
+    BOOST_CHECK_EQUAL (rime::get <std::string &> (v [3]), "def");
+    BOOST_CHECK_EQUAL (rime::get <int &> (v [4]), 7);
+    BOOST_CHECK (v [5].contains <void>());
+    BOOST_CHECK_EQUAL (rime::get <std::string &> (v [6]), "xxx");
+
+    // The columns.
+    BOOST_CHECK_EQUAL (v.column <int>().size(), 2u);
+    BOOST_CHECK_EQUAL (v.column <int>() [1], 7);
+    BOOST_CHECK_EQUAL (v.column <double>().size(), 1u);
+    BOOST_CHECK_EQUAL (v.column <std::string>().size(), 3u);
+
+    // Change an element through the reference.
+    rime::get <int &> (v [4]) = 8;
+    BOOST_CHECK_EQUAL (v.column <int>() [1], 8);
+
+    vector_type const & const_v = v;
+    BOOST_CHECK_EQUAL (rime::get <int const &> (const_v [4]), 8);
+    BOOST_CHECK_EQUAL (rime::get <std::string const &> (const_v [6]), "xxx");
+
+    // Push back a variant of a different type.
+    rime::variant <double, char const *> other ("ghi");
+    v.push_back (other);
+    BOOST_CHECK_EQUAL (v.which (7), 2u);
+    BOOST_CHECK_EQUAL (rime::get <std::string &> (v [7]), "ghi");
+
+    // Push back a variant of references.
+    v.push_back (const_v [0]);
+    BOOST_CHECK_EQUAL (v.which (8), 0u);
+    BOOST_CHECK_EQUAL (rime::get <int &> (v [8]), 5);
+
+    double total = 0;
+    int string_count = 0;
+    const_v.visit_all (sum (total, string_count));
+    BOOST_CHECK_EQUAL (total, 5 + 2.5 + 8 + 5);
+    BOOST_CHECK_EQUAL (string_count, 4);
+
+    v.clear();
+    BOOST_CHECK (v.empty());
+    BOOST_CHECK_EQUAL (v.column <std::string>().size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_vector_references) {
+    int i = 3;
+    double d = 4.5;
+    rime::variant_vector <int &, double &> v;
+    v.push_back (i);
+    v.push_back (d);
+
+    BOOST_CHECK_EQUAL (&rime::get <int &> (v [0]), &i);
+    BOOST_CHECK_EQUAL (&rime::get <double &> (v [1]), &d);
+
+    rime::get <double &> (v [1]) = 5.5;
+    BOOST_CHECK_EQUAL (d, 5.5);
+
+    // Const access still refers to the objects as they are.
+    rime::variant_vector <int &, double &> const & const_v = v;
+    BOOST_MPL_ASSERT ((std::is_same <decltype (const_v [0]),
+        rime::variant_ref <int, double>>));
+    rime::get <int &> (const_v [0]) = 4;
+    BOOST_CHECK_EQUAL (i, 4);
+}
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_vector_bool) {
+    rime::variant_vector <bool, int> v;
+    v.push_back (true);
+    v.push_back (5);
+    v.push_back (false);
+
+    BOOST_CHECK_EQUAL (rime::get <bool &> (v [0]), true);
+    BOOST_CHECK_EQUAL (rime::get <bool &> (v [2]), false);
+    rime::get <bool &> (v [2]) = true;
+    BOOST_CHECK_EQUAL (v.column <bool>() [1], true);
+    BOOST_CHECK_EQUAL (v.column <bool>().size(), 2u);
+}
+
+// A type whose unary operator& does not return its address.
+struct no_address {
+    int value;
+    void operator& () const {}
+};
+
+BOOST_AUTO_TEST_CASE (test_rime_variant_vector_overloaded_address) {
+    rime::variant_vector <no_address, int> v;
+    v.push_back (no_address {7});
+    v.push_back (8);
+    BOOST_CHECK_EQUAL (rime::get <no_address &> (v [0]).value, 7);
+    BOOST_CHECK_EQUAL (rime::get <int &> (v [1]), 8);
+}
+
+// Random access over more than one checkpoint.
+BOOST_AUTO_TEST_CASE (test_rime_variant_vector_checkpoints) {
+    typedef rime::variant_vector <int, double, void> vector_type;
+    std::size_t const size = 5 * vector_type::checkpoint_interval + 3;
+
+    vector_type v;
+    std::vector <int> expected;
+    for (std::size_t index = 0; index != size; ++ index) {
+        // An irregular pattern.
+        int value = int (index);
+        if (index % 3 == 0)
+            v.push_back (value);
+        else if (index % 7 < 3)
+            v.push_back (double (value));
+        else
+            v.push_back (rime::variant <int, double, void>());
+        expected.push_back (value);
+    }
+    BOOST_CHECK_EQUAL (v.size(), size);
+
+    vector_type const & const_v = v;
+    for (std::size_t index = 0; index != size; ++ index) {
+        if (index % 3 == 0) {
+            BOOST_CHECK_EQUAL (rime::get <int const &> (const_v [index]),
+                expected [index]);
+        } else if (index % 7 < 3) {
+            BOOST_CHECK_EQUAL (rime::get <double &> (v [index]),
+                double (expected [index]));
+        } else
+            BOOST_CHECK (v [index].contains <void>());
+    }
+
+    v.clear();
+    v.push_back (1.5);
+    BOOST_CHECK_EQUAL (rime::get <double &> (v [0]), 1.5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()